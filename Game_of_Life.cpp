@@ -9,6 +9,9 @@
 
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <memory>
+#include <cctype>
 
 // Uses cxxopts from https://github.com/jarro2783/cxxopts under the MIT license
 #include "cxxopts/cxxopts.hxx"
@@ -16,19 +19,40 @@
 #include "grid.h"
 #include "world.h"
 #include "zoo.h"
+#include "checkpoint_writer.h"
+#include "metrics.h"
+#include "perf_counters.h"
+#include "world_batch.h"
+#include "census.h"
 
 int main(int argc, char *argv[]) {
 
+    // Every frame is written through std::cout alone, so it need not stay synchronised with C stdio
+    std::ios::sync_with_stdio(false);
+
     cxxopts::Options options("Game_of_Life",
             "This program implements John Conway's Game of Life for Cellular Automaton (circa 1970).");
 
     // Declare the valid command line arguments and their types and default values.
     options.add_options()
-            ("f,file", "Load an ascii file from the provided path.",  cxxopts::value<std::string>())
-            ("o,output", "Save an ascii file to the provided path.",  cxxopts::value<std::string>())
-            ("s,steps","The number of steps to simulate the world.", cxxopts::value<int>()->default_value("10"))
+            ("f,file", "Load a file from the provided path, RLE if it ends in .rle, binary if .bgol, tiled if .tgol, otherwise ascii.",  cxxopts::value<std::string>())
+            ("o,output", "Save a file to the provided path, RLE if it ends in .rle, binary if .bgol, tiled if .tgol, otherwise ascii.",  cxxopts::value<std::string>())
+            ("s,steps","The number of steps to simulate the world.", cxxopts::value<long long>()->default_value("10"))
             ("e,every","Print world to the console every N steps. 0 disables printing.", cxxopts::value<int>()->default_value("0"))
             ("t,toroidal", "Simulate the Game of Life on a torus.", cxxopts::value<bool>()->default_value("false"))
+            ("engine", "The engine used to step the world: cells, bits, table or hashlife.", cxxopts::value<std::string>()->default_value("cells"))
+            ("rule", "The Life-like rule in B/S notation, e.g. B36/S23, or a Larger than Life rule, e.g. R5,C0,M1,S34..58,B34..45,NM.", cxxopts::value<std::string>()->default_value("B3/S23"))
+            ("threads", "The number of threads used to step the world. 0 uses every hardware thread.", cxxopts::value<int>()->default_value("1"))
+            ("checkpoint-every", "Write a checkpoint every N steps on a background thread. 0 disables checkpoints.", cxxopts::value<long long>()->default_value("0"))
+            ("checkpoint-dir", "The directory checkpoints are written to and resumed from.", cxxopts::value<std::string>()->default_value("checkpoints"))
+            ("detect-cycles", "Detect cycles of up to N generations and skip the whole cycles left. 0 disables detection.", cxxopts::value<int>()->default_value("0"))
+            ("metrics", "Write the timings of each generation and of each phase of the run as JSON lines to the provided path.", cxxopts::value<std::string>())
+            ("perf", "Count hardware events while stepping the world, such as cache and branch misses, and report them per generation and per cell.", cxxopts::value<bool>()->default_value("false"))
+            ("census", "Run N random soups on every thread instead of a world, and count the objects they settle into. 0 disables the census.", cxxopts::value<long long>()->default_value("0"))
+            ("soup-size", "The side of the square of random cells each soup of the census starts from, up to 64.", cxxopts::value<int>()->default_value("16"))
+            ("soup-generations", "The most generations each soup of the census runs for before its objects are counted.", cxxopts::value<long long>()->default_value("4096"))
+            ("seed", "The seed of the random soups of the census, the same seed always gives the same census.", cxxopts::value<long long>()->default_value("1"))
+            ("resume", "Resume from the newest complete checkpoint, if there is one, instead of the input file, under the rule it was written with.", cxxopts::value<bool>()->default_value("false"))
             ("h,help", "Print usage.");
 
     // Actually parse the command line arguments
@@ -41,52 +65,435 @@ int main(int argc, char *argv[]) {
     }
 
     // Parse the (potentially defaulted) parameters for this simulation
-    const int  steps    = result["steps"].as<int>();
+    const long long steps = result["steps"].as<long long>();
     const int  every    = result["every"].as<int>();
     const bool toroidal = result["toroidal"].as<bool>();
+    const std::string engine = result["engine"].as<std::string>();
+    const int  threads  = result["threads"].as<int>();
+    const long long checkpoint_every = result["checkpoint-every"].as<long long>();
+    const std::string checkpoint_dir = result["checkpoint-dir"].as<std::string>();
+    const bool resume = result["resume"].as<bool>();
+    const int detect_cycles = result["detect-cycles"].as<int>();
+
+    // Parse the rule before doing any work, so a typo fails fast
+    Rule rule;
+    std::unique_ptr<LargerThanLifeRule> extended_rule;
+    auto parse_rule = [&](const std::string &notation) {
+        try {
+            extended_rule.reset();
+            if (LargerThanLifeRule::is_notation(notation)) {
+                extended_rule.reset(new LargerThanLifeRule(notation));
+            }
+            else {
+                rule = Rule(notation);
+            }
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    };
+    parse_rule(result["rule"].as<std::string>());
+
+    // The format of the input and output files is picked by their extension
+    auto has_extension = [](const std::string &path, const std::string &extension) {
+        return path.size() >= extension.size() &&
+               std::equal(extension.rbegin(), extension.rend(), path.rbegin(),
+                          [](char a, char b) { return a == std::tolower((unsigned char)b); });
+    };
+
+    // The threads are used to parse the input file as well as to step the world
+    if (threads < 0) {
+        std::cerr << "The number of threads cannot be negative." << std::endl;
+        std::exit(-1);
+    }
+
+    // Run a census of random soups instead of a world if asked to
+    const long long census_soups = result["census"].as<long long>();
+    if (census_soups != 0) {
+        const int soup_size = result["soup-size"].as<int>();
+        const long long soup_generations = result["soup-generations"].as<long long>();
+        if (census_soups < 0 || soup_generations < 0 || soup_size < 1 || soup_size > 64) {
+            std::cerr << "The census needs a positive number of soups and generations, and a soup size from 1 to 64."
+                      << std::endl;
+            std::exit(-1);
+        }
+        if (extended_rule) {
+            std::cerr << "The census only supports Life-like rules." << std::endl;
+            std::exit(-1);
+        }
+
+        // Each soup is centred in its own 64x64 torus, small enough for the fastest kernel of WorldBatch
+        // and large enough for most soups to settle without meeting themselves across the edges. Spaceships
+        // escaping from a soup are removed and counted as they leave, before they can loop around the torus
+        const unsigned int side = 64;
+        const unsigned int x0 = (side - soup_size) / 2;
+        const unsigned int batch_size = 4096;
+        const Metrics::Clock::time_point census_start = Metrics::Clock::now();
+        Census census(rule);
+        census.set_threads(threads);
+        unsigned long long still_running = 0;
+        // The batch and its threads are made once, only a last part batch of soups needs a smaller one
+        auto make_batch = [&](const unsigned int count) {
+            WorldBatch batch(count, side);
+            batch.set_rule(rule);
+            batch.set_threads(threads);
+            batch.set_cycle_detection(30);
+            return batch;
+        };
+        WorldBatch batch = make_batch((unsigned int)std::min<long long>(batch_size, census_soups));
+        for (long long first = 0; first < census_soups; first += batch_size) {
+            const unsigned int count = (unsigned int)std::min<long long>(batch_size, census_soups - first);
+            if (count < batch.get_count()) {
+                batch = make_batch(count);
+            }
+            batch.randomize(result["seed"].as<long long>(), first, 0.5, x0, x0, x0 + soup_size, x0 + soup_size);
+            census.search(batch, soup_generations, true);
+            still_running += batch.get_running();
+        }
+        const double seconds = std::chrono::duration<double>(Metrics::Clock::now() - census_start).count();
+
+        std::cout << "Census of " << census.get_soups() << " soups of " << soup_size << "x" << soup_size
+                  << " cells under " << rule.to_string() << " in " << seconds << " s\n";
+        std::cout << "Stabilised " << census.get_soups() - still_running << " | Still running " << still_running
+                  << '\n';
+        for (const auto &count : census.get_counts()) {
+            std::cout << count.first << " " << count.second << '\n';
+        }
+        std::cout << std::flush;
+        return 0;
+    }
+
+    // Open the metrics file before doing any work, so the time spent loading is recorded too
+    std::unique_ptr<Metrics> metrics;
+    if (result.count("metrics")) {
+        try {
+            metrics.reset(new Metrics(result["metrics"].as<std::string>()));
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    // Open the performance counters before the world starts its threads, so they are counted too
+    std::unique_ptr<PerfCounters> counters;
+    if (result["perf"].as<bool>()) {
+        counters.reset(new PerfCounters());
+    }
 
     // Start with an empty grid
     Grid grid;
+    const Metrics::Clock::time_point load_start = Metrics::Clock::now();
+
+    // Resume from the newest complete checkpoint if asked to and there is one
+    long long step = 0;
+    bool resumed = false;
+    bool rule_restored = false;
+    if (resume) {
+        std::string path;
+        unsigned long long checkpoint_step = 0;
+        if (CheckpointWriter::find_latest(checkpoint_dir, path, checkpoint_step)) {
+            try {
+                grid = Zoo::load_tiled(path);
+            }
+            catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+                std::exit(-1);
+            }
+            step = (long long)checkpoint_step;
+            resumed = true;
 
-    // Attempt to read in and parse the input file as an ascii .gol file if a path was given
-    if (result.count("file")) {
+            // The checkpoint carries on under the rule it was written with, unless one was given on the command line
+            const std::string checkpoint_rule = CheckpointWriter::load_rule(path);
+            if (!checkpoint_rule.empty() && !result.count("rule")) {
+                parse_rule(checkpoint_rule);
+            }
+            rule_restored = !checkpoint_rule.empty();
+            std::cout << "Resuming from step " << step << " of " << steps << '\n';
+        }
+    }
+
+    // A checkpoint written without its rule still takes the rule named by an RLE input file
+    if (resumed && !rule_restored && result.count("file") && !result.count("rule")) {
+        const std::string path = result["file"].as<std::string>();
+        if (has_extension(path, ".rle")) {
+            std::string file_rule;
+            try {
+                Zoo::load_rle(path, &file_rule);
+            }
+            catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+                std::exit(-1);
+            }
+            if (!file_rule.empty()) {
+                parse_rule(file_rule);
+            }
+        }
+    }
+
+    // Otherwise attempt to read in and parse the input file if a path was given
+    if (!resumed && result.count("file")) {
+        const std::string path = result["file"].as<std::string>();
+        std::string file_rule;
         try {
-            grid = Zoo::load_ascii(result["file"].as<std::string>());
+            if (has_extension(path, ".rle")) {
+                grid = Zoo::load_rle(path, &file_rule);
+            }
+            else if (has_extension(path, ".bgol")) {
+                grid = Zoo::load_binary(path);
+            }
+            else if (has_extension(path, ".tgol")) {
+                grid = Zoo::load_tiled(path);
+            }
+            else {
+                grid = Zoo::load_ascii(path, threads);
+            }
         }
         catch (const std::exception &ex) {
             std::cerr << ex.what() << std::endl;
             std::exit(-1);
         }
+
+        // An RLE file names its own rule, which applies unless one was given on the command line
+        if (!file_rule.empty() && !result.count("rule")) {
+            parse_rule(file_rule);
+        }
+    }
+
+    if (metrics) {
+        metrics->add_phase(Metrics::Phase::LOAD, load_start, Metrics::Clock::now());
     }
 
     // Construct a world from the parsed grid
     World world(grid);
+    world.set_rule(rule);
+    if (extended_rule) {
+        world.set_rule(*extended_rule);
+    }
+
+    // Select the engine used to step the world
+    if (engine == "cells") {
+        world.set_engine(World::Engine::CELLS);
+    }
+    else if (engine == "bits") {
+        world.set_engine(World::Engine::BITS);
+    }
+    else if (engine == "table") {
+        world.set_engine(World::Engine::TABLE);
+    }
+    else if (engine == "hashlife") {
+        // HashLife simulates the unbounded plane, so long runs of --steps jump many generations at once
+        if (toroidal) {
+            std::cerr << "The hashlife engine does not support a toroidal world." << std::endl;
+            std::exit(-1);
+        }
+        if (rule.get_birth() & 1) {
+            std::cerr << "The hashlife engine does not support rules with birth on 0 neighbours." << std::endl;
+            std::exit(-1);
+        }
+        world.set_engine(World::Engine::HASHLIFE);
+    }
+    else {
+        std::cerr << "Unknown engine: " << engine << std::endl;
+        std::exit(-1);
+    }
+
+    // Start the threads used to step the world, they persist for the whole run
+    world.set_threads(threads);
+
+    // Look for the world repeating, so a dead, frozen or oscillating world is not stepped needlessly
+    if (detect_cycles < 0) {
+        std::cerr << "The longest period of cycle to detect cannot be negative." << std::endl;
+        std::exit(-1);
+    }
+    world.set_cycle_detection(detect_cycles);
+
+    // Start the thread checkpoints are written on, so the simulation never waits for the disk
+    if (checkpoint_every < 0) {
+        std::cerr << "The number of steps between checkpoints cannot be negative." << std::endl;
+        std::exit(-1);
+    }
+    std::unique_ptr<CheckpointWriter> checkpoints;
+    if (checkpoint_every > 0) {
+        try {
+            checkpoints.reset(new CheckpointWriter(checkpoint_dir,
+                extended_rule ? extended_rule->to_string() : rule.to_string()));
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
 
     // Print the initial state of the grid
+    Metrics::Clock::time_point render_start = Metrics::Clock::now();
     std::cout << "Initial state..." << std::endl
               << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells()  << std::endl
               << world.get_state() << std::endl;
+    if (metrics) {
+        metrics->add_phase(Metrics::Phase::RENDER, render_start, Metrics::Clock::now());
+    }
+
+    // The engines which step one generation at a time are recorded in groups sized by the metrics, see
+    // Metrics::get_group_size(), the others once per call so they keep the work they save across generations
+    const bool grouped_generations = metrics && (extended_rule || engine == "cells" || engine == "table");
+    const long long first_step = step;
+
+    // Perform the requested number of update steps, advancing in one call between each printed step or checkpoint
+    while (step < steps) {
+        long long target = steps;
+
+        // Print the state of the grid every N steps, after steps 1, N + 1, 2N + 1, ...
+        if (every > 0) {
+            target = std::min(target, step + 1 + ((every - (step % every)) % every));
+        }
+
+        // Checkpoint every N steps, after steps N, 2N, 3N, ...
+        if (checkpoint_every > 0) {
+            target = std::min(target, (step / checkpoint_every + 1) * checkpoint_every);
+        }
 
-    // Perform the requested number of update steps
-    for (int step = 0; step < steps; step++) {
-        world.step(toroidal);
+        if (grouped_generations) {
+            target = std::min(target, step + (long long)metrics->get_group_size());
+        }
+
+        if (counters) {
+            counters->start();
+        }
+        if (metrics) {
+            const Metrics::Clock::time_point step_start = Metrics::Clock::now();
+            world.advance(target - step, toroidal);
+            const Metrics::Clock::time_point step_end = Metrics::Clock::now();
+            metrics->add_phase(Metrics::Phase::STEP, step_start, step_end);
+            try {
+                if (grouped_generations && target - step == 1) {
+                    metrics->add_generation(target, step_start, step_end,
+                        world.get_alive_cells(), world.get_births(), world.get_deaths(), world.get_active_tiles());
+                }
+                else if (grouped_generations) {
+                    metrics->add_generations(target, target - step, step_start, step_end, world.get_alive_cells(),
+                        world.get_births(), world.get_deaths(), world.get_active_tiles());
+                }
+                else {
+                    metrics->add_generations(target, target - step, step_start, step_end, world.get_alive_cells(),
+                        world.get_active_tiles());
+                }
+            }
+            catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+                std::exit(-1);
+            }
+        }
+        else {
+            world.advance(target - step, toroidal);
+        }
+        if (counters) {
+            counters->stop();
+        }
+        step = target;
 
-        // Print the state of the grid every N steps
-        if ((every > 0) && (step % every == 0)) {
-            std::cout << "Step " << (step + 1) << " of " << steps << std::endl
+        if ((every > 0) && ((step - 1) % every == 0)) {
+            render_start = Metrics::Clock::now();
+            std::cout << "Step " << step << " of " << steps << '\n'
                       << world.get_state() << std::endl;
+            if (metrics) {
+                metrics->add_phase(Metrics::Phase::RENDER, render_start, Metrics::Clock::now());
+            }
+        }
+
+        if (checkpoints && step % checkpoint_every == 0) {
+            const Metrics::Clock::time_point checkpoint_start = Metrics::Clock::now();
+            try {
+                checkpoints->submit(world.get_state(), (unsigned long long)step);
+            }
+            catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+                std::exit(-1);
+            }
+            if (metrics) {
+                metrics->add_phase(Metrics::Phase::CHECKPOINT, checkpoint_start, Metrics::Clock::now());
+            }
+        }
+    }
+
+    // Wait for the last checkpoint to reach the disk
+    if (checkpoints) {
+        try {
+            checkpoints->flush();
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
         }
     }
 
     // Print the final state of the grid
+    render_start = Metrics::Clock::now();
     std::cout << "Final state..." << std::endl
               << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells()  << std::endl
               << world.get_state() << std::endl;
+    if (world.get_period() > 0) {
+        std::cout << "Cycle of period " << world.get_period() << " detected, at phase " << world.get_phase() << std::endl;
+    }
+    if (metrics) {
+        metrics->add_phase(Metrics::Phase::RENDER, render_start, Metrics::Clock::now());
+    }
+
+    // Report the hardware events of stepping the world, as totals and per generation and cell stepped
+    if (counters) {
+        const double generations = (double)std::max(1LL, step - first_step);
+        const double cells = generations * std::max(1u, world.get_total_cells());
+        if (counters->is_available()) {
+            std::cout << "Performance counters over " << (step - first_step) << " generations..." << std::endl;
+            for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+                const PerfCounters::Event event = (PerfCounters::Event)i;
+                if (counters->is_available(event)) {
+                    const double count = (double)counters->get_count(event);
+                    std::cout << PerfCounters::get_name(event) << " " << count << " | Per generation "
+                              << count / generations << " | Per cell " << count / cells << std::endl;
+                }
+                else {
+                    std::cout << PerfCounters::get_name(event) << " unavailable" << std::endl;
+                }
+            }
+        }
+        else {
+            std::cout << "Performance counters are unavailable, check /proc/sys/kernel/perf_event_paranoid." << std::endl;
+        }
+    }
 
     // Attempt to save to the output directory if a path was given
     if (result.count("output")) {
+        const std::string path = result["output"].as<std::string>();
+        const Metrics::Clock::time_point save_start = Metrics::Clock::now();
+        try {
+            if (has_extension(path, ".rle")) {
+                Zoo::save_rle(path, world.get_state(), extended_rule ? extended_rule->to_string() : rule.to_string());
+            }
+            else if (has_extension(path, ".bgol")) {
+                Zoo::save_binary(path, world.get_state());
+            }
+            else if (has_extension(path, ".tgol")) {
+                Zoo::save_tiled(path, world.get_state());
+            }
+            else {
+                Zoo::save_ascii(path, world.get_state());
+            }
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+        if (metrics) {
+            metrics->add_phase(Metrics::Phase::SAVE, save_start, Metrics::Clock::now());
+        }
+    }
+
+    // Write the summary of the timings
+    if (metrics) {
         try {
-            Zoo::save_ascii(result["output"].as<std::string>(), world.get_state());
+            metrics->finish();
         }
         catch (const std::exception &ex) {
             std::cerr << ex.what() << std::endl;
@@ -0,0 +1,475 @@
+/**
+ * Micro-benchmarks of the hot paths of Grid, World and Zoo.
+ *
+ * Run with -h or --help to print the usage message.
+ * i.e.
+ * ./bench --help
+ *
+ * Every benchmark is run once to warm up and then timed over a number of repetitions. The minimum, median,
+ * mean and standard deviation of the repetitions are reported, along with throughputs computed from the median:
+ *      - cells_per_second, the cells processed per second (cells x generations for World benchmarks).
+ *      - generations_per_second, for World benchmarks.
+ *      - bytes_per_second, for Zoo benchmarks, the size of the file written or read per second.
+ *
+ * With --perf the hardware events of the timed repetitions are counted too, see PerfCounters, and reported per
+ * repetition, per generation and per cell, so a change in throughput can be traced to cache or branch misses.
+ *
+ * Progress is printed to std::cerr as each benchmark finishes, and the results are written as a single JSON
+ * document to std::cout, or to the path given with --json, so they can be tracked over time.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+
+// Uses cxxopts from https://github.com/jarro2783/cxxopts under the MIT license
+#include "cxxopts/cxxopts.hxx"
+
+#include "grid.h"
+#include "world.h"
+#include "zoo.h"
+#include "perf_counters.h"
+
+/**
+ * The timings and throughputs of one benchmark.
+ */
+struct BenchResult {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> parameters;
+    unsigned int repetitions;
+    double min_seconds;
+    double median_seconds;
+    double mean_seconds;
+    double stddev_seconds;
+    double cells;
+    double generations;
+    double bytes;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+/**
+ * The settings shared by every benchmark, parsed from the command line.
+ */
+struct BenchSettings {
+    unsigned int repetitions;
+    unsigned int threads;
+    std::string filter;
+    std::string scratch;
+    PerfCounters *counters;
+};
+
+/**
+ * make_soup(width, height, density, seed)
+ *
+ * Make a grid of random cells, each alive with the given probability, using a xorshift generator
+ * so even the largest boards are filled quickly.
+ */
+static Grid make_soup(const unsigned int width, const unsigned int height, const double density, uint64_t seed) {
+    Grid grid(width, height);
+    const uint64_t threshold = (uint64_t)(density * 4294967296.0);
+    seed = seed * 0x9e3779b97f4a7c15ULL + 1;
+    Cell *cells = grid.data();
+    const size_t total = (size_t)width * height;
+    for (size_t i = 0; i < total; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        cells[i] = (seed & 0xFFFFFFFFULL) < threshold ? Cell::ALIVE : Cell::DEAD;
+    }
+    return grid;
+}
+
+/**
+ * run_benchmark(settings, results, name, parameters, cells, generations, bytes, setup, body)
+ *
+ * Time a benchmark, print its progress and append its result. setup is run before every repetition and is
+ * not timed, body is the timed part. The throughputs are computed from the median time, and the hardware events
+ * counted, if any, are averaged over the repetitions.
+ * Benchmarks whose name and parameters do not contain the filter are skipped.
+ */
+static void run_benchmark(const BenchSettings &settings, std::vector<BenchResult> &results, const std::string &name,
+    const std::vector<std::pair<std::string, std::string>> &parameters, const double cells, const double generations,
+    const double bytes, const std::function<void()> &setup, const std::function<void()> &body) {
+    std::string label = name;
+    for (const auto &parameter : parameters) {
+        label += " " + parameter.first + "=" + parameter.second;
+    }
+    if (!settings.filter.empty() && label.find(settings.filter) == std::string::npos) {
+        return;
+    }
+
+    setup();
+    body();
+    std::vector<double> seconds;
+    if (settings.counters) {
+        settings.counters->reset();
+    }
+    for (unsigned int i = 0; i < settings.repetitions; i++) {
+        setup();
+        if (settings.counters) {
+            settings.counters->start();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        const auto end = std::chrono::steady_clock::now();
+        if (settings.counters) {
+            settings.counters->stop();
+        }
+        seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.parameters = parameters;
+    result.repetitions = settings.repetitions;
+    std::vector<double> sorted = seconds;
+    std::sort(sorted.begin(), sorted.end());
+    result.min_seconds = sorted.front();
+    result.median_seconds = sorted.size() % 2 ? sorted[sorted.size() / 2] :
+        (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+    double sum = 0;
+    for (double s : seconds) {
+        sum += s;
+    }
+    result.mean_seconds = sum / seconds.size();
+    double squares = 0;
+    for (double s : seconds) {
+        squares += (s - result.mean_seconds) * (s - result.mean_seconds);
+    }
+    result.stddev_seconds = seconds.size() > 1 ? std::sqrt(squares / (seconds.size() - 1)) : 0;
+    result.cells = cells;
+    result.generations = generations;
+    result.bytes = bytes;
+    if (settings.counters) {
+        for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+            const PerfCounters::Event event = (PerfCounters::Event)i;
+            if (settings.counters->is_available(event)) {
+                result.counters.push_back({PerfCounters::get_name(event),
+                    (double)settings.counters->get_count(event) / settings.repetitions});
+            }
+        }
+    }
+    results.push_back(result);
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-70s %10.3f ms", label.c_str(), result.median_seconds * 1000);
+    std::cerr << line;
+    if (cells > 0) {
+        std::snprintf(line, sizeof(line), " %10.3g cells/s", cells / result.median_seconds);
+        std::cerr << line;
+    }
+    if (bytes > 0) {
+        std::snprintf(line, sizeof(line), " %10.3g bytes/s", bytes / result.median_seconds);
+        std::cerr << line;
+    }
+    std::cerr << '\n';
+}
+
+/**
+ * engine_name(engine)
+ *
+ * Gets the name of an engine as used on the command line of Game_of_Life.
+ */
+static std::string engine_name(const World::Engine engine) {
+    switch (engine) {
+        case World::Engine::CELLS:
+            return "cells";
+        case World::Engine::BITS:
+            return "bits";
+        case World::Engine::TABLE:
+            return "table";
+        default:
+            return "hashlife";
+    }
+}
+
+/**
+ * format_number(value)
+ *
+ * Format a number for JSON, which has no representation of infinity or NaN.
+ */
+static std::string format_number(const double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+    return buffer;
+}
+
+/**
+ * write_json(output, settings, results)
+ *
+ * Write every result as one JSON document.
+ */
+static void write_json(std::ostream &output, const BenchSettings &settings, const std::vector<BenchResult> &results) {
+    output << "{\n  \"repetitions\": " << settings.repetitions << ",\n  \"threads\": " << settings.threads
+           << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &result = results[i];
+        output << (i ? "," : "") << "\n    {\"name\": \"" << result.name << "\", \"parameters\": {";
+        for (size_t j = 0; j < result.parameters.size(); j++) {
+            output << (j ? ", " : "") << "\"" << result.parameters[j].first << "\": \"" << result.parameters[j].second << "\"";
+        }
+        output << "}, \"min_seconds\": " << format_number(result.min_seconds)
+               << ", \"median_seconds\": " << format_number(result.median_seconds)
+               << ", \"mean_seconds\": " << format_number(result.mean_seconds)
+               << ", \"stddev_seconds\": " << format_number(result.stddev_seconds);
+        if (result.cells > 0) {
+            output << ", \"cells_per_second\": " << format_number(result.cells / result.median_seconds);
+        }
+        if (result.generations > 0) {
+            output << ", \"generations_per_second\": " << format_number(result.generations / result.median_seconds);
+        }
+        if (result.bytes > 0) {
+            output << ", \"bytes_per_second\": " << format_number(result.bytes / result.median_seconds);
+        }
+        if (!result.counters.empty()) {
+            // The counts of one repetition, then normalised by the generations and cells it processed
+            const std::pair<const char*, double> scales[] = {
+                {"counters", 1}, {"counters_per_generation", result.generations}, {"counters_per_cell", result.cells}};
+            for (const auto &scale : scales) {
+                if (scale.second <= 0) {
+                    continue;
+                }
+                output << ", \"" << scale.first << "\": {";
+                for (size_t j = 0; j < result.counters.size(); j++) {
+                    output << (j ? ", " : "") << "\"" << result.counters[j].first << "\": "
+                           << format_number(result.counters[j].second / scale.second);
+                }
+                output << "}";
+            }
+        }
+        output << "}";
+    }
+    output << "\n  ]\n}\n";
+}
+
+/**
+ * bench_world(settings, results, sizes, densities)
+ *
+ * Benchmark World::step and World::advance on every engine, board size, density and topology.
+ * The number of generations per repetition shrinks with the board, so each repetition processes
+ * roughly the same number of cells.
+ */
+static void bench_world(const BenchSettings &settings, std::vector<BenchResult> &results,
+    const std::vector<unsigned int> &sizes, const std::vector<double> &densities) {
+    const World::Engine engines[] = {World::Engine::CELLS, World::Engine::BITS, World::Engine::TABLE, World::Engine::HASHLIFE};
+    for (unsigned int size : sizes) {
+        const double cells = (double)size * size;
+        const unsigned long long generations = std::max(1ULL, (unsigned long long)(double(1 << 26) / cells));
+        for (double density : densities) {
+            const Grid soup = make_soup(size, size, density, size);
+            for (World::Engine engine : engines) {
+                for (bool torodial : {false, true}) {
+                    // HashLife has no toroidal mode, and its memory grows without bound on large random soups
+                    if (engine == World::Engine::HASHLIFE && (torodial || size > 1024)) {
+                        continue;
+                    }
+                    World world(soup);
+                    world.set_engine(engine);
+                    world.set_threads(settings.threads);
+                    const std::vector<std::pair<std::string, std::string>> parameters = {
+                        {"size", std::to_string(size)}, {"density", format_number(density)},
+                        {"engine", engine_name(engine)}, {"toroidal", torodial ? "true" : "false"},
+                        {"generations", std::to_string(generations)}};
+
+                    // Every repetition starts from the soup, so they all time the same generations
+                    auto reset = [&]() {
+                        world = World(soup);
+                        world.set_engine(engine);
+                        world.set_threads(settings.threads);
+                    };
+                    if (engine != World::Engine::HASHLIFE) {
+                        run_benchmark(settings, results, "world.step", parameters, cells * generations, (double)generations,
+                            0, reset, [&]() {
+                                for (unsigned long long i = 0; i < generations; i++) {
+                                    world.step(torodial);
+                                }
+                            });
+                    }
+                    run_benchmark(settings, results, "world.advance", parameters, cells * generations, (double)generations,
+                        0, reset, [&]() { world.advance(generations, torodial); });
+                }
+            }
+        }
+    }
+}
+
+/**
+ * bench_grid(settings, results, sizes)
+ *
+ * Benchmark the bulk operations of Grid on every board size.
+ */
+static void bench_grid(const BenchSettings &settings, std::vector<BenchResult> &results, const std::vector<unsigned int> &sizes) {
+    auto nothing = []() {};
+    for (unsigned int size : sizes) {
+        const double cells = (double)size * size;
+        Grid grid = make_soup(size, size, 0.35, size + 1);
+        const Grid stamp = make_soup(size / 2, size / 2, 0.35, size + 2);
+        const std::vector<std::pair<std::string, std::string>> parameters = {{"size", std::to_string(size)}};
+        volatile unsigned int sink = 0;
+
+        run_benchmark(settings, results, "grid.get_alive_cells", parameters, cells, 0, 0, nothing,
+            [&]() { sink = grid.get_alive_cells(); });
+        run_benchmark(settings, results, "grid.crop", parameters, cells / 4, 0, 0, nothing,
+            [&]() { sink = grid.crop(size / 4, size / 4, size / 4 + size / 2, size / 4 + size / 2).get_width(); });
+        run_benchmark(settings, results, "grid.merge", parameters, cells / 4, 0, 0, nothing,
+            [&]() { grid.merge(stamp, size / 4, size / 4, false); });
+        run_benchmark(settings, results, "grid.merge_alive_only", parameters, cells / 4, 0, 0, nothing,
+            [&]() { grid.merge(stamp, size / 4, size / 4, true); });
+        run_benchmark(settings, results, "grid.rotate", parameters, cells, 0, 0, nothing,
+            [&]() { sink = grid.rotate(1).get_width(); });
+        (void)sink;
+    }
+}
+
+/**
+ * file_size(path)
+ *
+ * Gets the size of a file in bytes.
+ */
+static double file_size(const std::string &path) {
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    return ifs.is_open() ? (double)ifs.tellg() : 0;
+}
+
+/**
+ * bench_zoo(settings, results, sizes)
+ *
+ * Benchmark saving and loading every file format of Zoo on every board size, through the scratch directory.
+ */
+static void bench_zoo(const BenchSettings &settings, std::vector<BenchResult> &results, const std::vector<unsigned int> &sizes) {
+    struct Format {
+        std::string name;
+        std::string extension;
+        std::function<void(const std::string&, const Grid&)> save;
+        std::function<Grid(const std::string&)> load;
+    };
+    const std::vector<Format> formats = {
+        {"ascii", ".gol", [](const std::string &p, const Grid &g) { Zoo::save_ascii(p, g); },
+            [](const std::string &p) { return Zoo::load_ascii(p); }},
+        {"binary", ".bgol", [](const std::string &p, const Grid &g) { Zoo::save_binary(p, g); },
+            [](const std::string &p) { return Zoo::load_binary(p); }},
+        {"rle", ".rle", [](const std::string &p, const Grid &g) { Zoo::save_rle(p, g); },
+            [](const std::string &p) { return Zoo::load_rle(p); }},
+        {"tiled", ".tgol", [](const std::string &p, const Grid &g) { Zoo::save_tiled(p, g); },
+            [](const std::string &p) { return Zoo::load_tiled(p); }},
+    };
+    auto nothing = []() {};
+    for (unsigned int size : sizes) {
+        const double cells = (double)size * size;
+        for (double density : {0.01, 0.35}) {
+            const Grid grid = make_soup(size, size, density, size + 3);
+            for (const Format &format : formats) {
+                const std::string path = settings.scratch + "/bench" + format.extension;
+                const std::vector<std::pair<std::string, std::string>> parameters = {
+                    {"format", format.name}, {"size", std::to_string(size)}, {"density", format_number(density)}};
+                format.save(path, grid);
+                const double bytes = file_size(path);
+                run_benchmark(settings, results, "zoo.save", parameters, cells, 0, bytes, nothing,
+                    [&]() { format.save(path, grid); });
+                run_benchmark(settings, results, "zoo.load", parameters, cells, 0, bytes, nothing,
+                    [&]() { format.load(path); });
+                std::remove(path.c_str());
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    cxxopts::Options options("bench", "Micro-benchmarks of the hot paths of Grid, World and Zoo, reported as JSON.");
+
+    // Declare the valid command line arguments and their types and default values.
+    options.add_options()
+            ("r,repetitions", "The number of timed repetitions of each benchmark.", cxxopts::value<int>()->default_value("5"))
+            ("max-size", "The largest board edge to benchmark, from 64 up to 16384 in powers of 4.", cxxopts::value<int>()->default_value("16384"))
+            ("threads", "The number of threads used to step the world. 0 uses every hardware thread.", cxxopts::value<int>()->default_value("1"))
+            ("filter", "Only run the benchmarks whose name and parameters contain this text.", cxxopts::value<std::string>()->default_value(""))
+            ("scratch", "The directory the Zoo benchmarks write their files to.", cxxopts::value<std::string>()->default_value("."))
+            ("perf", "Count hardware events, such as cache and branch misses, over the timed repetitions.", cxxopts::value<bool>()->default_value("false"))
+            ("json", "Write the JSON results to the provided path instead of std::cout.", cxxopts::value<std::string>())
+            ("h,help", "Print usage.");
+
+    // Actually parse the command line arguments
+    auto result = options.parse(argc, argv);
+
+    // Print the help usage for this program
+    if (result.count("help")) {
+        std::cout << options.help() << std::endl;
+        std::exit(0);
+    }
+
+    const int repetitions = result["repetitions"].as<int>();
+    const int max_size = result["max-size"].as<int>();
+    const int threads = result["threads"].as<int>();
+    if (repetitions < 1 || max_size < 64 || threads < 0) {
+        std::cerr << "The repetitions must be positive, the largest size at least 64, and the threads not negative." << std::endl;
+        std::exit(-1);
+    }
+
+    BenchSettings settings;
+    settings.repetitions = (unsigned int)repetitions;
+    settings.threads = (unsigned int)threads;
+    settings.filter = result["filter"].as<std::string>();
+    settings.scratch = result["scratch"].as<std::string>();
+
+    // The counters are opened before any world starts its threads, so the threads are counted too
+    std::unique_ptr<PerfCounters> counters;
+    if (result["perf"].as<bool>()) {
+        counters.reset(new PerfCounters());
+        if (!counters->is_available()) {
+            std::cerr << "Performance counters are unavailable, check /proc/sys/kernel/perf_event_paranoid." << std::endl;
+        }
+    }
+    settings.counters = counters.get();
+
+    // The boards from 64x64 up to the largest size, growing 4x along each edge
+    std::vector<unsigned int> sizes;
+    for (unsigned int size = 64; size <= (unsigned int)max_size; size *= 4) {
+        sizes.push_back(size);
+    }
+
+    // Grid and Zoo are not benchmarked on the largest boards, where they only measure the memory bandwidth
+    std::vector<unsigned int> smaller_sizes;
+    for (unsigned int size : sizes) {
+        if (size <= 4096) {
+            smaller_sizes.push_back(size);
+        }
+    }
+
+    std::vector<BenchResult> results;
+    try {
+        bench_world(settings, results, sizes, {0.05, 0.35});
+        bench_grid(settings, results, smaller_sizes);
+        bench_zoo(settings, results, smaller_sizes);
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+
+    if (result.count("json")) {
+        std::ofstream ofs(result["json"].as<std::string>());
+        if (!ofs.is_open()) {
+            std::cerr << "The JSON file cannot be opened." << std::endl;
+            std::exit(-1);
+        }
+        write_json(ofs, settings, results);
+    }
+    else {
+        write_json(std::cout, settings, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,533 @@
+/**
+ * Implements a class representing a bit-packed 2d grid of cells.
+ *      - New cells are initialized to Cell::DEAD.
+ *      - BitGrids can be built from a Grid and converted back to a Grid.
+ *      - BitGrids can return counts of the alive and dead cells using a popcount per word.
+ *      - BitGrids can be stepped forward one generation of Conway's Game of Life, 64 cells at a time.
+ *
+ * A BitGrid uses 1/8th of the memory of a Grid of the same size, which is what makes it the better
+ * backing store for long runs on very large boards.
+ */
+#include "bitgrid.h"
+#include "bitlogic.h"
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * popcount64(word)
+ *
+ * Count the set bits in a 64 bit word.
+ */
+static inline unsigned int popcount64(const uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    uint64_t v = word - ((word >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (unsigned int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * BitGrid::BitGrid()
+ *
+ * Construct an empty bit grid of size 0x0.
+ *
+ * @example
+ *
+ *      // Make a 0x0 empty bit grid
+ *      BitGrid grid;
+ *
+ */
+BitGrid::BitGrid() : BitGrid(0) {
+}
+
+/**
+ * BitGrid::BitGrid(square_size)
+ *
+ * Construct a bit grid with the desired size filled with dead cells.
+ *
+ * @example
+ *
+ *      // Make a 16x16 bit grid
+ *      BitGrid grid(16);
+ *
+ * @param square_size
+ *      The edge size to use for the width and height of the grid.
+ */
+BitGrid::BitGrid(const unsigned int square_size) : BitGrid(square_size, square_size) {
+}
+
+/**
+ * BitGrid::BitGrid(width, height)
+ *
+ * Construct a bit grid with the desired size filled with dead cells.
+ * Each row is padded up to a whole number of 64 bit words.
+ *
+ * @example
+ *
+ *      // Make a 100x9 bit grid, each row is stored in 2 words
+ *      BitGrid grid(100, 9);
+ *
+ * @param width
+ *      The width of the grid.
+ *
+ * @param height
+ *      The height of the grid.
+ */
+BitGrid::BitGrid(const unsigned int width, const unsigned int height)
+    : width(width), height(height), words_per_row((width + 63) / 64),
+      words((size_t)((width + 63) / 64) * height, 0) {
+}
+
+/**
+ * BitGrid::BitGrid(grid)
+ *
+ * Construct a bit grid with the size and contents of an existing Grid.
+ *
+ * @example
+ *
+ *      // Pack a glider into a bit grid
+ *      BitGrid grid(Zoo::glider());
+ *
+ * @param grid
+ *      The grid to pack.
+ */
+BitGrid::BitGrid(const Grid &grid) : BitGrid(grid.get_width(), grid.get_height()) {
+    for (unsigned int y = 0; y < this->height; y++) {
+        uint64_t *words = this->row(y);
+        const Cell *cells = grid.row(y);
+        for (unsigned int x = 0; x < this->width; x += 64) {
+            words[x / 64] = BitGrid::pack(cells + x, std::min(64u, this->width - x));
+        }
+    }
+}
+
+/**
+ * BitGrid::pack(cells, count)
+ *
+ * Pack up to 64 cells into the bits of a word, bit x for cell x, the layout of one word of a BitGrid row.
+ * With AVX2 32 cells, or with SSE2 16 cells, are compared against Cell::ALIVE at once and their byte masks
+ * gathered with a movemask.
+ *
+ * @example
+ *
+ *      // Pack the first 64 cells of a row of a grid
+ *      uint64_t word = BitGrid::pack(grid.row(0), std::min(64u, grid.get_width()));
+ *
+ * @param cells
+ *      The cells to pack.
+ *
+ * @param count
+ *      The number of cells to pack, at most 64.
+ *
+ * @return
+ *      The packed cells, bits past count are 0.
+ */
+uint64_t BitGrid::pack(const Cell *cells, const unsigned int count) {
+    uint64_t bits = 0;
+    unsigned int x = 0;
+#if defined(__AVX2__)
+    const __m256i alive_avx = _mm256_set1_epi8((char)Cell::ALIVE);
+    for (; x + 32 <= count; x += 32) {
+        const __m256i block = _mm256_loadu_si256((const __m256i*)(cells + x));
+        bits |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, alive_avx)) << x;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i alive_sse = _mm_set1_epi8((char)Cell::ALIVE);
+    for (; x + 16 <= count; x += 16) {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(cells + x));
+        bits |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, alive_sse)) << x;
+    }
+#endif
+    for (; x < count; x++) {
+        bits |= (uint64_t)(cells[x] == Cell::ALIVE) << x;
+    }
+    return bits;
+}
+
+/**
+ * BitGrid::get_width()
+ *
+ * Gets the current width of the grid in cells.
+ *
+ * @return
+ *      The width of the grid.
+ */
+unsigned int BitGrid::get_width() const {
+    return this->width;
+}
+
+/**
+ * BitGrid::get_height()
+ *
+ * Gets the current height of the grid in cells.
+ *
+ * @return
+ *      The height of the grid.
+ */
+unsigned int BitGrid::get_height() const {
+    return this->height;
+}
+
+/**
+ * BitGrid::get_words_per_row()
+ *
+ * Gets the number of 64 bit words used to store each row.
+ *
+ * @return
+ *      The row stride in words.
+ */
+unsigned int BitGrid::get_words_per_row() const {
+    return this->words_per_row;
+}
+
+/**
+ * BitGrid::get_total_cells()
+ *
+ * Gets the total number of cells in the grid.
+ *
+ * @return
+ *      The number of total cells.
+ */
+unsigned int BitGrid::get_total_cells() const {
+    return this->width * this->height;
+}
+
+/**
+ * BitGrid::get_alive_cells()
+ *
+ * Counts how many cells in the grid are alive, one word at a time.
+ * Padding bits are always 0 so they never contribute to the count.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+unsigned int BitGrid::get_alive_cells() const {
+    unsigned int alive_counter = 0;
+    for (const uint64_t word : this->words) {
+        alive_counter += popcount64(word);
+    }
+    return alive_counter;
+}
+
+/**
+ * BitGrid::get_dead_cells()
+ *
+ * Counts how many cells in the grid are dead.
+ *
+ * @return
+ *      The number of dead cells.
+ */
+unsigned int BitGrid::get_dead_cells() const {
+    return this->get_total_cells() - this->get_alive_cells();
+}
+
+/**
+ * BitGrid::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate.
+ *
+ * @example
+ *
+ *      // Read the cell at coordinate (1, 2)
+ *      Cell cell = grid.get(1, 2);
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      The value of the desired cell, Cell::ALIVE or Cell::DEAD.
+ *
+ * @throws
+ *      std::invalid_argument if x,y is not a valid coordinate within the grid.
+ */
+Cell BitGrid::get(const unsigned int x, const unsigned int y) const {
+    if (!are_valid_coordinates(x, y)) {
+        throw std::invalid_argument("get() : Invalid coordinates.");
+    }
+    return ((this->row(y)[x / 64] >> (x % 64)) & 1) ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * BitGrid::set(x, y, cell)
+ *
+ * Overwrites the value at the desired coordinate.
+ *
+ * @example
+ *
+ *      // Assign to a cell at coordinate (1, 2)
+ *      grid.set(1, 2, Cell::ALIVE);
+ *
+ * @param x
+ *      The x coordinate of the cell to update.
+ *
+ * @param y
+ *      The y coordinate of the cell to update.
+ *
+ * @param cell
+ *      The value to be written to the selected cell.
+ *
+ * @throws
+ *      std::invalid_argument if x,y is not a valid coordinate within the grid.
+ */
+void BitGrid::set(const unsigned int x, const unsigned int y, Cell cell) {
+    if (!are_valid_coordinates(x, y)) {
+        throw std::invalid_argument("set() : Invalid coordinates.");
+    }
+    const uint64_t bit = (uint64_t)1 << (x % 64);
+    if (cell == Cell::ALIVE) {
+        this->row(y)[x / 64] |= bit;
+    }
+    else {
+        this->row(y)[x / 64] &= ~bit;
+    }
+}
+
+/**
+ * BitGrid::row(y)
+ *
+ * Gets the words backing row y, without any bounds checking.
+ * The row is get_words_per_row() words long.
+ *
+ * @param y
+ *      The row to access, must be less than the height of the grid.
+ *
+ * @return
+ *      A pointer to the first word of the row.
+ */
+const uint64_t* BitGrid::row(const unsigned int y) const {
+    return this->words.data() + (size_t)y * this->words_per_row;
+}
+
+uint64_t* BitGrid::row(const unsigned int y) {
+    return this->words.data() + (size_t)y * this->words_per_row;
+}
+
+/**
+ * BitGrid::to_grid()
+ *
+ * Unpack the bit grid into a regular Grid of the same size and contents.
+ *
+ * @example
+ *
+ *      // Print a bit grid to the console
+ *      std::cout << bits.to_grid() << std::endl;
+ *
+ * @return
+ *      A new Grid containing the cells of this bit grid.
+ */
+Grid BitGrid::to_grid() const {
+    Grid grid(this->width, this->height);
+    for (unsigned int y = 0; y < this->height; y++) {
+        const uint64_t *words = this->row(y);
+        Cell *cells = grid.row(y);
+        for (unsigned int x = 0; x < this->width; x++) {
+            if ((words[x / 64] >> (x % 64)) & 1) {
+                cells[x] = Cell::ALIVE;
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * BitGrid::step(next, toroidal, rule)
+ *
+ * Take one step in a Life-like rule, Conway's Game of Life unless given, writing the result into next.
+ * next is resized to match this grid if needed.
+ *
+ * The kernel works on whole words. For each word it builds the 8 neighbour words (the row above and below
+ * shifted west, centre, and east, plus this row shifted west and east) and sums them with a tree of bitwise
+ * full adders into 4 bit-planes, so every bit position holds its own 0-8 neighbour count. The rules are then
+ * a handful of bitwise operations on those planes, computing 64 cells at once, see bitlogic.h.
+ *
+ * The topology matches World::step(toroidal): when toroidal = false cells outside of the grid are dead,
+ * when toroidal = true coordinates wrap to the opposite side of the grid.
+ *
+ * @example
+ *
+ *      // Step a packed glider forward one generation
+ *      BitGrid curr(Zoo::glider()), next;
+ *      curr.step(next);
+ *      std::swap(curr, next);
+ *
+ * @param next
+ *      The bit grid to write the next generation to. Must not be this grid.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom. Defaults to false.
+ *
+ * @param rule
+ *      Optional parameter. The rule to apply, defaults to B3/S23.
+ */
+void BitGrid::step(BitGrid &next, const bool torodial, const Rule &rule) const {
+    if (next.width != this->width || next.height != this->height) {
+        next = BitGrid(this->width, this->height);
+    }
+    this->step_rows(next, 0, this->height, torodial, rule);
+}
+
+/**
+ * BitGrid::step_rows(next, y0, y1, toroidal, rule)
+ *
+ * Compute rows [y0, y1) of the next generation into next, as BitGrid::step(next, toroidal, rule) does for every row.
+ * Only rows [y0, y1) of next are written, so disjoint row bands can be computed by different threads at once.
+ *
+ * @example
+ *
+ *      // Compute the top and bottom half of the next generation separately
+ *      BitGrid next(curr.get_width(), curr.get_height());
+ *      curr.step_rows(next, 0, curr.get_height() / 2);
+ *      curr.step_rows(next, curr.get_height() / 2, curr.get_height());
+ *
+ * @param next
+ *      The bit grid to write the next generation to. Must be the same size as this grid, and not this grid.
+ *
+ * @param y0
+ *      The first row to compute.
+ *
+ * @param y1
+ *      One past the last row to compute.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the step will consider the grid as a torus. Defaults to false.
+ *
+ * @param rule
+ *      Optional parameter. The rule to apply, defaults to B3/S23.
+ *
+ * @throws
+ *      std::invalid_argument if next is not the same size as this grid or the rows are out of range.
+ */
+void BitGrid::step_rows(BitGrid &next, const unsigned int y0, const unsigned int y1, const bool torodial,
+    const Rule &rule) const {
+    if (next.width != this->width || next.height != this->height) {
+        throw std::invalid_argument("step_rows() : Next grid is not the same size.");
+    }
+    if (y0 > y1 || y1 > this->height) {
+        throw std::invalid_argument("step_rows() : Invalid rows.");
+    }
+    BitGrid::step_words(this->words.data(), next.words.data(), this->width, this->height, y0, y1, torodial, rule);
+}
+
+/**
+ * BitGrid::step_words(words, next, width, height, y0, y1, toroidal, rule)
+ *
+ * The kernel of BitGrid::step_rows(next, y0, y1, toroidal, rule), on any buffer laid out as the words of a BitGrid,
+ * so grids packed back to back in one buffer can be stepped without a BitGrid each. No arguments are checked.
+ *
+ * @example
+ *
+ *      // Step the second of two 32x32 grids packed back to back, one word per row
+ *      std::vector<uint64_t> words(2 * 32), next(32);
+ *      BitGrid::step_words(words.data() + 32, next.data(), 32, 32, 0, 32);
+ *
+ * @param words
+ *      The rows of the current generation, each of (width + 63) / 64 words.
+ *
+ * @param next
+ *      The rows to write the next generation to, laid out as words. Must not overlap words.
+ *
+ * @param width
+ *      The width of the grid.
+ *
+ * @param height
+ *      The height of the grid.
+ *
+ * @param y0
+ *      The first row to compute.
+ *
+ * @param y1
+ *      One past the last row to compute, at most height.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the step will consider the grid as a torus. Defaults to false.
+ *
+ * @param rule
+ *      Optional parameter. The rule to apply, defaults to B3/S23.
+ */
+void BitGrid::step_words(const uint64_t *words, uint64_t *next, const unsigned int width, const unsigned int height,
+    const unsigned int y0, const unsigned int y1, const bool torodial, const Rule &rule) {
+    if (width == 0 || y0 >= y1) {
+        return;
+    }
+
+    const unsigned int n = (width + 63) / 64;
+    const unsigned int last_bit = (width - 1) % 64;
+    const uint64_t last_mask = (last_bit == 63) ? ~(uint64_t)0 : (((uint64_t)1 << (last_bit + 1)) - 1);
+    // The row beyond a bounded edge, kept between calls so stepping many small grids does not allocate
+    static thread_local std::vector<uint64_t> empty;
+    if (empty.size() < n) {
+        empty.resize(n, 0);
+    }
+    const bool conway = rule == Rule(ConwayRule());
+    const uint16_t birth = rule.get_birth();
+    const uint16_t survival = rule.get_survival();
+
+    for (unsigned int y = y0; y < y1; y++) {
+        const uint64_t *rows[3];
+        rows[1] = words + (size_t)y * n;
+        if (y > 0) {
+            rows[0] = rows[1] - n;
+        }
+        else {
+            rows[0] = torodial ? words + (size_t)(height - 1) * n : empty.data();
+        }
+        if (y + 1 < height) {
+            rows[2] = rows[1] + n;
+        }
+        else {
+            rows[2] = torodial ? words : empty.data();
+        }
+
+        uint64_t *out = next + (size_t)y * n;
+        for (unsigned int i = 0; i < n; i++) {
+            // west[r] has the cell at x - 1 in bit x, east[r] has the cell at x + 1 in bit x
+            uint64_t west[3], centre[3], east[3];
+            for (int r = 0; r < 3; r++) {
+                const uint64_t *row = rows[r];
+                uint64_t carry_in_west = 0;
+                uint64_t carry_in_east = 0;
+                if (i > 0) {
+                    carry_in_west = row[i - 1] >> 63;
+                }
+                else if (torodial) {
+                    carry_in_west = row[n - 1] >> last_bit;
+                }
+                if (i + 1 < n) {
+                    carry_in_east = row[i + 1] << 63;
+                }
+                else if (torodial) {
+                    carry_in_east = (row[0] & 1) << last_bit;
+                }
+                centre[r] = row[i];
+                west[r] = (row[i] << 1) | (carry_in_west & 1);
+                east[r] = (row[i] >> 1) | carry_in_east;
+            }
+
+            // Sum the 8 neighbour words and apply the rules to all 64 cells at once.
+            const BitLogic::Counts counts = BitLogic::count_neighbours(west[0], centre[0], east[0],
+                west[1], east[1], west[2], centre[2], east[2]);
+            uint64_t result = conway ? BitLogic::conway(counts, centre[1])
+                                     : BitLogic::apply(counts, centre[1], birth, survival);
+            if (i + 1 == n) {
+                result &= last_mask;
+            }
+            out[i] = result;
+        }
+    }
+}
+
+bool BitGrid::are_valid_coordinates(const unsigned int x, const unsigned int y) const {
+    return x < this->width && y < this->height;
+}
@@ -0,0 +1,51 @@
+/**
+ * Declares a class representing a bit-packed 2d grid of cells.
+ * Rich documentation for the api and behaviour the BitGrid class can be found in bitgrid.cpp.
+ */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the BitGrid class for representing a 2d grid of cells using one bit per cell.
+ *
+ * Every row starts on a fresh 64 bit word, bit (x % 64) of word (x / 64) holds the cell in column x.
+ * Bits past the width of the grid in the last word of a row are always 0.
+ */
+class BitGrid {
+    private:
+        unsigned int width;
+        unsigned int height;
+        unsigned int words_per_row;
+        std::vector<uint64_t> words;
+
+        bool are_valid_coordinates(const unsigned int x, const unsigned int y) const;
+
+    public:
+        BitGrid();
+        explicit BitGrid(const unsigned int square_size);
+        BitGrid(const unsigned int width, const unsigned int height);
+        explicit BitGrid(const Grid &grid);
+
+        unsigned int get_width() const;
+        unsigned int get_height() const;
+        unsigned int get_words_per_row() const;
+        unsigned int get_total_cells() const;
+        unsigned int get_alive_cells() const;
+        unsigned int get_dead_cells() const;
+        Cell get(const unsigned int x, const unsigned int y) const;
+        void set(const unsigned int x, const unsigned int y, Cell cell);
+        const uint64_t* row(const unsigned int y) const;
+        uint64_t* row(const unsigned int y);
+        Grid to_grid() const;
+        void step(BitGrid &next, const bool torodial = false, const Rule &rule = Rule()) const;
+        void step_rows(BitGrid &next, const unsigned int y0, const unsigned int y1, const bool torodial = false,
+            const Rule &rule = Rule()) const;
+
+        static uint64_t pack(const Cell *cells, const unsigned int count);
+        static void step_words(const uint64_t *words, uint64_t *next, const unsigned int width, const unsigned int height,
+            const unsigned int y0, const unsigned int y1, const bool torodial = false, const Rule &rule = Rule());
+
+};
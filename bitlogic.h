@@ -0,0 +1,129 @@
+/**
+ * Declares the word-parallel Game of Life logic shared by the bit-packed engines.
+ *
+ * Each bit position of a uint64_t is an independent cell. Given the 8 words holding the neighbours of 64 cells,
+ * the neighbours are summed with a tree of bitwise full adders into 4 bit-planes (1s, 2s, 4s and 8s),
+ * so each bit position ends up with its own 0-8 neighbour count, and the rules become bitwise operations.
+ *
+ * These are defined inline in the header so they can be inlined into the inner loop of every engine.
+ * They are templates on the word type, so a vector of words, such as a GCC vector extension type, gets the same
+ * logic one register at a time. Word must support the bitwise operators and value-initialize to 0.
+ */
+#pragma once
+#include <cstdint>
+
+namespace BitLogic {
+
+    /**
+     * The neighbour counts of one cell per bit of a word, one bit-plane per power of two.
+     */
+    template <typename Word>
+    struct CountsOf {
+        Word ones;
+        Word twos;
+        Word fours;
+        Word eights;
+    };
+
+    // The neighbour counts of 64 cells.
+    typedef CountsOf<uint64_t> Counts;
+
+    /**
+     * BitLogic::count_neighbours(a, b, c, d, e, f, g, h)
+     *
+     * Sum 8 neighbour words bit position by bit position.
+     *
+     * @return
+     *      The neighbour count of each bit position as 4 bit-planes.
+     */
+    template <typename Word>
+    inline CountsOf<Word> count_neighbours(const Word a, const Word b, const Word c, const Word d,
+        const Word e, const Word f, const Word g, const Word h) {
+        const Word s0 = a ^ b ^ c, c0 = (a & b) | (c & (a ^ b));
+        const Word s1 = d ^ e ^ f, c1 = (d & e) | (f & (d ^ e));
+        const Word s2 = g ^ h,     c2 = g & h;
+
+        const Word ones = s0 ^ s1 ^ s2;
+        const Word c3 = (s0 & s1) | (s2 & (s0 ^ s1));
+
+        const Word t0 = c0 ^ c1 ^ c2, c4 = (c0 & c1) | (c2 & (c0 ^ c1));
+        const Word twos = t0 ^ c3,    c5 = t0 & c3;
+
+        return CountsOf<Word>{ones, twos, c4 ^ c5, c4 & c5};
+    }
+
+    /**
+     * BitLogic::conway(counts, alive)
+     *
+     * Apply the rules of Conway's Game of Life: alive next generation with exactly 3 neighbours,
+     * or alive now with exactly 2.
+     *
+     * @param counts
+     *      The neighbour counts of each bit position.
+     *
+     * @param alive
+     *      The current cells.
+     *
+     * @return
+     *      The cells of the next generation.
+     */
+    template <typename Word>
+    inline Word conway(const CountsOf<Word> &counts, const Word alive) {
+        return ~counts.eights & ~counts.fours & counts.twos & (counts.ones | alive);
+    }
+
+    /**
+     * BitLogic::equals(counts, n)
+     *
+     * Find the bit positions whose neighbour count is exactly n.
+     *
+     * @return
+     *      A word with the bits set where the count is n.
+     */
+    template <typename Word>
+    inline Word equals(const CountsOf<Word> &counts, const unsigned int n) {
+        return ((n & 1) ? counts.ones : ~counts.ones) & ((n & 2) ? counts.twos : ~counts.twos) &
+               ((n & 4) ? counts.fours : ~counts.fours) & ((n & 8) ? counts.eights : ~counts.eights);
+    }
+
+    /**
+     * BitLogic::apply(counts, alive, birth, survival)
+     *
+     * Apply any Life-like rule, see rule.h for the layout of the birth and survival masks.
+     * Only the counts named by the rule are compared, Conway's rules should use BitLogic::conway(counts, alive).
+     *
+     * @param counts
+     *      The neighbour counts of each bit position.
+     *
+     * @param alive
+     *      The current cells.
+     *
+     * @param birth
+     *      Bit n is set if a dead cell with n alive neighbours becomes alive.
+     *
+     * @param survival
+     *      Bit n is set if an alive cell with n alive neighbours stays alive.
+     *
+     * @return
+     *      The cells of the next generation.
+     */
+    template <typename Word>
+    inline Word apply(const CountsOf<Word> &counts, const Word alive, const uint16_t birth, const uint16_t survival) {
+        Word next{};
+        for (unsigned int n = 0; n <= 8; n++) {
+            const bool born = (birth >> n) & 1;
+            const bool kept = (survival >> n) & 1;
+            if (born && kept) {
+                next |= equals(counts, n);
+            }
+            else if (born) {
+                next |= equals(counts, n) & ~alive;
+            }
+            else if (kept) {
+                next |= equals(counts, n) & alive;
+            }
+        }
+        return next;
+    }
+
+};
@@ -0,0 +1,16 @@
+/**
+ * Declares the precomputed block transition tables used by the World::Engine::TABLE engine.
+ * Rich documentation for the layout of the tables can be found in blocktable.cpp.
+ */
+#pragma once
+#include <cstdint>
+#include "rule.h"
+
+namespace BlockTable {
+
+    // One entry for every 4x4 block of cells.
+    const unsigned int ENTRIES = 1 << 16;
+
+    const uint8_t* get_table(const Rule &rule = Rule());
+
+};
@@ -0,0 +1,1054 @@
+/**
+ * Implements a class which tallies the objects left behind by soups of the Game of Life.
+ *      - A world is separated into groups of alive cells within 2 cells of each other, and each group is split into
+ *        the parts which evolve independently of each other, so two blocks side by side count as two blocks.
+ *      - Each object is stepped on its own to find its period and whether it moves, and its canonical form is the
+ *        smallest encoding of any of its phases under any of the 8 rotations and reflections.
+ *      - The canonical hash of an object is looked up in a table of known objects, which holds the common still
+ *        lifes, oscillators and spaceships, including Zoo::glider, Zoo::r_pentomino and Zoo::light_weight_spaceship.
+ *      - Unknown objects are named as apgsearch does: xs<population> for still lifes, xp<period> for oscillators and
+ *        xq<period> for spaceships, followed by their canonical hash. Objects which do not repeat within the longest
+ *        period looked for are counted as unstable.
+ *      - The name of each shape of object and the parts of each shape of group are cached, so they are only
+ *        stepped the first time they are seen.
+ */
+#include "census.h"
+#include "world.h"
+#include "zoo.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <iterator>
+#include <functional>
+
+typedef std::vector<std::pair<int, int>> Cells;
+
+// The worlds of a batch handed to a thread at a time.
+static const unsigned int CHUNK_SIZE = 64;
+
+// The generations between looks for escaping spaceships, see Census::search(batch, generations, toroidal). It is
+// a multiple of 4, the period of the glider and of the light, middle and heavyweight spaceships, so each shows the
+// same phase at every look and is named at its second look. In the 32 generations of two looks a glider moves 8
+// cells, well short of the half of a 64 cell torus it crosses before it reaches the ash again.
+static const unsigned long long ESCAPE_INTERVAL = 16;
+
+// Spaceships are only looked for further than this fraction of the size of a world from its middle. The ash of
+// most soups settles within the middle half of the world, so the looks skip it, and a spaceship past it still has
+// half the world to cross before it comes back around the torus.
+static const double ESCAPE_RADIUS = 0.25;
+
+// A spaceship is only escaping once no other cell is within this many cells of its centre. The cells and sparks of
+// the common spaceships reach 3 cells from their centre, so 2 dead cells are left between them and anything else,
+// too far for either to change the other's next generation.
+static const int ESCAPE_DISTANCE = 5;
+
+// The most cells a group can have to be looked at as a spaceship, those of the largest phase of the heavyweight
+// spaceship. Larger groups are part of the ash, and are not grown any further.
+static const size_t ESCAPE_CELLS = 18;
+
+/**
+ * by_row(a, b)
+ *
+ * Orders cells by row then column, the order of normalise(cells) and get_cells(grid).
+ */
+static bool by_row(const std::pair<int, int> &a, const std::pair<int, int> &b) {
+    return a.second != b.second ? a.second < b.second : a.first < b.first;
+}
+
+/**
+ * normalise(cells)
+ *
+ * Move cells so the top left corner of their bounding box is at (0, 0), and sort them by row then column,
+ * so equal shapes in different places have equal cell lists.
+ */
+static Cells normalise(Cells cells) {
+    if (cells.empty()) {
+        return cells;
+    }
+    int min_x = cells[0].first, min_y = cells[0].second;
+    for (const auto &cell : cells) {
+        min_x = std::min(min_x, cell.first);
+        min_y = std::min(min_y, cell.second);
+    }
+    for (auto &cell : cells) {
+        cell.first -= min_x;
+        cell.second -= min_y;
+    }
+    std::sort(cells.begin(), cells.end(), by_row);
+    return cells;
+}
+
+/**
+ * encode(cells)
+ *
+ * Encode normalised cells as their bounding box followed by one character per cell of it, row by row.
+ */
+static std::string encode(const Cells &cells) {
+    int width = 0, height = 0;
+    for (const auto &cell : cells) {
+        width = std::max(width, cell.first + 1);
+        height = std::max(height, cell.second + 1);
+    }
+    std::string code = std::to_string(width) + "x" + std::to_string(height) + ":";
+    const size_t start = code.size();
+    code.append((size_t)width * height, '0');
+    for (const auto &cell : cells) {
+        code[start + (size_t)cell.second * width + cell.first] = '1';
+    }
+    return code;
+}
+
+/**
+ * transform(cells, symmetry)
+ *
+ * Apply one of the 8 rotations and reflections of the square to cells, then normalise them.
+ */
+static Cells transform(const Cells &cells, const unsigned int symmetry) {
+    Cells result;
+    result.reserve(cells.size());
+    for (const auto &cell : cells) {
+        const int x = cell.first, y = cell.second;
+        switch (symmetry) {
+            case 0: result.push_back({x, y}); break;
+            case 1: result.push_back({-y, x}); break;
+            case 2: result.push_back({-x, -y}); break;
+            case 3: result.push_back({y, -x}); break;
+            case 4: result.push_back({-x, y}); break;
+            case 5: result.push_back({y, x}); break;
+            case 6: result.push_back({x, -y}); break;
+            default: result.push_back({-y, -x}); break;
+        }
+    }
+    return normalise(result);
+}
+
+/**
+ * get_cells(grid)
+ *
+ * Gets the coordinates of the alive cells of a grid.
+ */
+static Cells get_cells(const Grid &grid) {
+    Cells cells;
+    for (unsigned int y = 0; y < grid.get_height(); y++) {
+        const Cell *row = grid.row(y);
+        for (unsigned int x = 0; x < grid.get_width(); x++) {
+            if (row[x] == Cell::ALIVE) {
+                cells.push_back({(int)x, (int)y});
+            }
+        }
+    }
+    return cells;
+}
+
+/**
+ * hash_code(code)
+ *
+ * Hash a canonical encoding with FNV-1a, finished with the finalizer of splitmix64.
+ */
+static uint64_t hash_code(const std::string &code) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : code) {
+        hash = (hash ^ (unsigned char)c) * 0x100000001b3ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/**
+ * The behaviour of an object stepped on its own.
+ */
+struct Behaviour {
+    std::string canonical;
+    unsigned int period;
+    int dx;
+    int dy;
+};
+
+/**
+ * analyse(cells, rule, max_period)
+ *
+ * Step an object on its own, with room to move max_period cells in any direction, until it repeats its shape.
+ * Its canonical form is the smallest encoding of any phase seen under any symmetry, or of its first phase alone
+ * if it does not repeat, so an unstable object is only equal to the same shape.
+ */
+static Behaviour analyse(const Cells &cells, const Rule &rule, const unsigned int max_period) {
+    const Cells first = normalise(cells);
+    const std::string first_code = encode(first);
+    int width = 0, height = 0;
+    for (const auto &cell : first) {
+        width = std::max(width, cell.first + 1);
+        height = std::max(height, cell.second + 1);
+    }
+
+    const int margin = (int)max_period + 2;
+    Grid grid(width + 2 * margin, height + 2 * margin);
+    for (const auto &cell : first) {
+        grid(cell.first + margin, cell.second + margin) = Cell::ALIVE;
+    }
+    World world(grid);
+    world.set_rule(rule);
+
+    Behaviour behaviour{"", 0, 0, 0};
+    std::vector<Cells> phases(1, first);
+    for (unsigned int generation = 1; generation <= max_period; generation++) {
+        world.step();
+        const Cells next = get_cells(world.get_state());
+        if (next.empty()) {
+            break;
+        }
+        const Cells shape = normalise(next);
+        if (encode(shape) == first_code) {
+            // The shape is the same, so its bounding box has moved as far as it has
+            behaviour.period = generation;
+            behaviour.dx = margin;
+            behaviour.dy = margin;
+            for (const auto &cell : next) {
+                behaviour.dx = std::min(behaviour.dx, cell.first);
+                behaviour.dy = std::min(behaviour.dy, cell.second);
+            }
+            behaviour.dx -= margin;
+            behaviour.dy -= margin;
+            break;
+        }
+        phases.push_back(shape);
+    }
+    if (behaviour.period == 0) {
+        phases.resize(1);
+    }
+
+    for (const Cells &phase : phases) {
+        for (unsigned int symmetry = 0; symmetry < 8; symmetry++) {
+            const std::string code = encode(transform(phase, symmetry));
+            if (behaviour.canonical.empty() || code < behaviour.canonical) {
+                behaviour.canonical = code;
+            }
+        }
+    }
+    return behaviour;
+}
+
+/**
+ * get_components(cells)
+ *
+ * Split cells into the groups connected through their 8 neighbours.
+ */
+static std::vector<Cells> get_components(const Cells &cells) {
+    std::vector<Cells> components;
+    std::vector<unsigned char> seen(cells.size(), 0);
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < cells.size(); i++) {
+        if (seen[i]) {
+            continue;
+        }
+        Cells component;
+        seen[i] = 1;
+        stack.push_back(i);
+        while (!stack.empty()) {
+            const std::pair<int, int> cell = cells[stack.back()];
+            stack.pop_back();
+            component.push_back(cell);
+            for (size_t j = 0; j < cells.size(); j++) {
+                if (!seen[j] && std::abs(cells[j].first - cell.first) <= 1 &&
+                    std::abs(cells[j].second - cell.second) <= 1) {
+                    seen[j] = 1;
+                    stack.push_back(j);
+                }
+            }
+        }
+        std::sort(component.begin(), component.end(), by_row);
+        components.push_back(component);
+    }
+    return components;
+}
+
+/**
+ * evolve(cells, width, height, rule, generations)
+ *
+ * Step cells on their own inside a width x height box, with room to grow generations cells past it on every side,
+ * and get the cells of each generation after the first, in the coordinates of the box ordered by row.
+ * Stepping stops as soon as a generation repeats, so settled ash costs a couple of steps.
+ */
+static std::vector<Cells> evolve(const Cells &cells, const int width, const int height, const Rule &rule,
+    const unsigned int generations) {
+    const int margin = (int)generations + 2;
+    Grid grid(width + 2 * margin, height + 2 * margin);
+    for (const auto &cell : cells) {
+        grid(cell.first + margin, cell.second + margin) = Cell::ALIVE;
+    }
+    World world(grid);
+    world.set_rule(rule);
+
+    // Once a generation repeats an earlier one in place, the rest of the history repeats too
+    std::vector<Cells> history(1, cells);
+    std::sort(history[0].begin(), history[0].end(), by_row);
+    while (history.size() <= generations) {
+        world.step();
+        Cells next = get_cells(world.get_state());
+        for (auto &cell : next) {
+            cell.first -= margin;
+            cell.second -= margin;
+        }
+        const auto repeat = std::find(history.begin(), history.end(), next);
+        if (repeat != history.end()) {
+            const size_t period = history.end() - repeat;
+            while (history.size() <= generations) {
+                history.push_back(history[history.size() - period]);
+            }
+            break;
+        }
+        history.push_back(next);
+    }
+    history.erase(history.begin());
+    return history;
+}
+
+/**
+ * get_neighbour(parts, index)
+ *
+ * Gets the index of the other part of a group with the cell closest to a part.
+ */
+static size_t get_neighbour(const std::vector<Cells> &parts, const size_t index) {
+    size_t closest = index == 0 ? 1 : 0;
+    int closest_distance = -1;
+    for (size_t j = 0; j < parts.size(); j++) {
+        if (j == index) {
+            continue;
+        }
+        for (const auto &a : parts[index]) {
+            for (const auto &b : parts[j]) {
+                const int distance = std::max(std::abs(a.first - b.first), std::abs(a.second - b.second));
+                if (closest_distance < 0 || distance < closest_distance) {
+                    closest_distance = distance;
+                    closest = j;
+                }
+            }
+        }
+    }
+    return closest;
+}
+
+/**
+ * combine(a, b)
+ *
+ * Combine two lists of cells ordered by row into one.
+ */
+static Cells combine(const Cells &a, const Cells &b) {
+    Cells cells;
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(cells), by_row);
+    return cells;
+}
+
+/**
+ * is_independent(parts, history)
+ *
+ * Check that parts of a group evolve together exactly as they do on their own, where history(cells) gets the
+ * generations of some cells stepped on their own, see evolve(cells, width, height, rule, generations).
+ */
+static bool is_independent(const std::vector<Cells> &parts,
+    const std::function<const std::vector<Cells>&(const Cells&)> &history) {
+    Cells together;
+    std::vector<Cells> apart;
+    for (const Cells &part : parts) {
+        together = combine(together, part);
+        const std::vector<Cells> &generations = history(part);
+        apart.resize(generations.size());
+        for (size_t generation = 0; generation < generations.size(); generation++) {
+            apart[generation] = combine(apart[generation], generations[generation]);
+        }
+    }
+    return history(together) == apart;
+}
+
+/**
+ * make_pattern(rows)
+ *
+ * Make a grid from rows of text, '#' for alive cells.
+ */
+static Grid make_pattern(const std::vector<std::string> &rows) {
+    Grid grid((unsigned int)rows[0].size(), (unsigned int)rows.size());
+    for (unsigned int y = 0; y < rows.size(); y++) {
+        for (unsigned int x = 0; x < rows[y].size(); x++) {
+            if (rows[y][x] == '#') {
+                grid(x, y) = Cell::ALIVE;
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * Census::Census(rule, max_period)
+ *
+ * Construct an empty census of the objects of a rule. Under Conway's Game of Life the table of known objects
+ * starts with the common still lifes, oscillators and spaceships.
+ *
+ * @example
+ *
+ *      // Count the objects left by a 1000 soups
+ *      Census census;
+ *      WorldBatch batch(1000, 64);
+ *      batch.set_cycle_detection(30);
+ *      batch.randomize(1, 0, 0.5, 24, 24, 40, 40);
+ *      batch.advance(10000, true);
+ *      census.add(batch, true);
+ *      for (const auto &count : census.get_counts()) {
+ *          std::cout << count.first << " " << count.second << std::endl;
+ *      }
+ *
+ * @param rule
+ *      Optional parameter. The rule objects are stepped with, defaults to B3/S23.
+ *
+ * @param max_period
+ *      Optional parameter. The longest period of oscillator or spaceship recognised, defaults to 30.
+ */
+Census::Census(const Rule &rule, const unsigned int max_period) : rule(rule), max_period(max_period), soups(0) {
+    if (rule != Rule()) {
+        return;
+    }
+    this->add_known("glider", Zoo::glider());
+    this->add_known("light_weight_spaceship", Zoo::light_weight_spaceship());
+    this->add_known("r_pentomino", Zoo::r_pentomino());
+    this->add_known("block", make_pattern({"##", "##"}));
+    this->add_known("blinker", make_pattern({"###"}));
+    this->add_known("beehive", make_pattern({".##.", "#..#", ".##."}));
+    this->add_known("loaf", make_pattern({".##.", "#..#", ".#.#", "..#."}));
+    this->add_known("boat", make_pattern({"##.", "#.#", ".#."}));
+    this->add_known("ship", make_pattern({"##.", "#.#", ".##"}));
+    this->add_known("tub", make_pattern({".#.", "#.#", ".#."}));
+    this->add_known("pond", make_pattern({".##.", "#..#", "#..#", ".##."}));
+    this->add_known("long_boat", make_pattern({"##..", "#.#.", ".#.#", "..#."}));
+    this->add_known("barge", make_pattern({".#..", "#.#.", ".#.#", "..#."}));
+    this->add_known("toad", make_pattern({".###", "###."}));
+    this->add_known("beacon", make_pattern({"##..", "##..", "..##", "..##"}));
+    this->add_known("pentadecathlon", make_pattern({"..#....#..", "##.####.##", "..#....#.."}));
+}
+
+/**
+ * Census::add_known(name, pattern)
+ *
+ * Add an object to the table of known objects, so every phase and orientation of it is counted under its name.
+ *
+ * @example
+ *
+ *      // Name the middleweight spaceship
+ *      census.add_known("middle_weight_spaceship", mwss);
+ *
+ * @param name
+ *      The name to count the object under.
+ *
+ * @param pattern
+ *      Any phase of the object, in any orientation.
+ */
+void Census::add_known(const std::string &name, const Grid &pattern) {
+    this->known[this->get_canonical_hash(pattern)] = name;
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    this->objects.clear();
+    this->parts.clear();
+}
+
+/**
+ * Census::get_canonical_hash(pattern)
+ *
+ * Gets the canonical hash of an object, which is the same for each of its phases in any place and orientation.
+ *
+ * @param pattern
+ *      The object.
+ *
+ * @return
+ *      The hash of the canonical form of the object.
+ */
+uint64_t Census::get_canonical_hash(const Grid &pattern) const {
+    return hash_code(analyse(get_cells(pattern), this->rule, this->max_period).canonical);
+}
+
+/**
+ * Census::classify(pattern)
+ *
+ * Gets the name an object is counted under, see Census::get_counts().
+ *
+ * @example
+ *
+ *      // Prints "glider"
+ *      std::cout << census.classify(Zoo::glider().rotate(1)) << std::endl;
+ *
+ * @param pattern
+ *      The object.
+ *
+ * @return
+ *      The name of the object in the table of known objects, or a name made from its behaviour and canonical hash.
+ */
+std::string Census::classify(const Grid &pattern) {
+    return this->get_object(get_cells(pattern)).name;
+}
+
+/**
+ * Census::get_object(cells)
+ *
+ * Private helper which names an object and finds how far it moves, analysing it only if its shape has not been
+ * seen before. It may be called from many threads at once.
+ */
+Census::Object Census::get_object(const std::vector<std::pair<int, int>> &cells) {
+    const std::string key = encode(normalise(cells));
+    {
+        std::lock_guard<std::mutex> lock(this->cache_mutex);
+        const auto found = this->objects.find(key);
+        if (found != this->objects.end()) {
+            return found->second;
+        }
+    }
+
+    const Behaviour behaviour = analyse(cells, this->rule, this->max_period);
+    const uint64_t hash = hash_code(behaviour.canonical);
+    const bool moving = behaviour.dx != 0 || behaviour.dy != 0;
+    Object object{"", behaviour.dx, behaviour.dy};
+    const auto known = this->known.find(hash);
+    if (known != this->known.end()) {
+        object.name = known->second;
+    }
+    else if (behaviour.period == 0) {
+        object.name = "unstable";
+    }
+    else {
+        char buffer[64];
+        const char *prefix = moving ? "xq" : (behaviour.period > 1 ? "xp" : "xs");
+        const unsigned long long number = behaviour.period > 1 || moving ? behaviour.period : cells.size();
+        std::snprintf(buffer, sizeof(buffer), "%s%llu_%016llx", prefix, number, (unsigned long long)hash);
+        object.name = buffer;
+    }
+
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    this->objects[key] = object;
+    return object;
+}
+
+/**
+ * Census::split(cells)
+ *
+ * Private helper which splits a group of cells into the parts which evolve independently, splitting it only if its
+ * shape has not been seen before. The group is first split into its 8-connected components, then any two of them
+ * which affect each other within the longest period looked for are merged, until every pair left is independent.
+ * A part which dies out on its own is then merged into the part closest to it. If the parts left do not evolve
+ * independently all together, the group is kept whole.
+ * It may be called from many threads at once.
+ */
+std::vector<std::vector<std::pair<int, int>>> Census::split(const std::vector<std::pair<int, int>> &cells) {
+    int min_x = cells[0].first, min_y = cells[0].second;
+    for (const auto &cell : cells) {
+        min_x = std::min(min_x, cell.first);
+        min_y = std::min(min_y, cell.second);
+    }
+    const Cells group = normalise(cells);
+    const std::string key = encode(group);
+
+    std::vector<Cells> found;
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> lock(this->cache_mutex);
+        const auto entry = this->parts.find(key);
+        if (entry != this->parts.end()) {
+            found = entry->second;
+            cached = true;
+        }
+    }
+
+    if (!cached) {
+        int width = 0, height = 0;
+        for (const auto &cell : group) {
+            width = std::max(width, cell.first + 1);
+            height = std::max(height, cell.second + 1);
+        }
+        // Each part is stepped once however many times it is compared
+        std::map<Cells, std::vector<Cells>> histories;
+        auto history = [&](const Cells &part) -> const std::vector<Cells>& {
+            auto entry = histories.find(part);
+            if (entry == histories.end()) {
+                entry = histories.emplace(part, evolve(part, width, height, this->rule, this->max_period)).first;
+            }
+            return entry->second;
+        };
+
+        found = get_components(group);
+        bool merged = found.size() > 1;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < found.size() && !merged; i++) {
+                for (size_t j = i + 1; j < found.size() && !merged; j++) {
+                    if (!is_independent({found[i], found[j]}, history)) {
+                        found[i] = combine(found[i], found[j]);
+                        found.erase(found.begin() + j);
+                        merged = true;
+                    }
+                }
+            }
+        }
+
+        // A part which dies out on its own, such as the spark of a spaceship, belongs with a part beside it
+        for (size_t i = 0; i < found.size() && found.size() > 1; ) {
+            if (!history(found[i]).back().empty()) {
+                i++;
+                continue;
+            }
+            const size_t j = get_neighbour(found, i);
+            found[j] = combine(found[j], found[i]);
+            found.erase(found.begin() + i);
+            i = 0;
+        }
+        if (found.size() > 2 && !is_independent(found, history)) {
+            found.assign(1, group);
+        }
+        std::lock_guard<std::mutex> lock(this->cache_mutex);
+        this->parts[key] = found;
+    }
+
+    // The parts are cached relative to the group, so they are moved back to where the group is
+    for (Cells &part : found) {
+        for (auto &cell : part) {
+            cell.first += min_x;
+            cell.second += min_y;
+        }
+    }
+    return found;
+}
+
+/**
+ * Census::get_threads()
+ *
+ * Gets the number of threads the worlds of a batch are separated and named on.
+ *
+ * @return
+ *      The number of threads, 1 unless changed with Census::set_threads(threads).
+ */
+unsigned int Census::get_threads() const {
+    if (this->pool) {
+        return this->pool->get_threads();
+    }
+    return 1;
+}
+
+/**
+ * Census::set_threads(threads)
+ *
+ * Selects how many threads Census::add(batch, toroidal) runs on.
+ *
+ * @param threads
+ *      The number of threads to use. 1 runs on the calling thread only, 0 uses one thread per hardware thread.
+ */
+void Census::set_threads(const unsigned int threads) {
+    if (threads == 1) {
+        this->pool.reset();
+    }
+    else {
+        this->pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+/**
+ * Census::separate(state, toroidal)
+ *
+ * Separate the alive cells of a world into groups of cells connected through steps of up to 2 cells in each
+ * direction. Cells 2 apart can still affect each other's neighbours, so objects such as a lightweight spaceship
+ * or a beacon stay in one piece. Objects which settled close together are grouped too, and are only told apart
+ * when the census splits each group into the parts which evolve independently.
+ *
+ * @param state
+ *      The world to separate.
+ *
+ * @param toroidal
+ *      Optional parameter. If true objects can wrap across the edges of the world, and their cells are given
+ *      relative to where they were first found, past the edges if need be. Defaults to false.
+ *
+ * @return
+ *      The cells of each group.
+ */
+std::vector<std::vector<std::pair<int, int>>> Census::separate(const Grid &state, const bool torodial) {
+    const int width = (int)state.get_width();
+    const int height = (int)state.get_height();
+    std::vector<unsigned char> seen((size_t)width * height, 0);
+    std::vector<Cells> objects;
+    Cells stack;
+
+    for (int y = 0; y < height; y++) {
+        const Cell *row = state.row(y);
+        for (int x = 0; x < width; x++) {
+            if (row[x] != Cell::ALIVE || seen[(size_t)y * width + x]) {
+                continue;
+            }
+            Cells object;
+            seen[(size_t)y * width + x] = 1;
+            stack.push_back({x, y});
+            while (!stack.empty()) {
+                const std::pair<int, int> cell = stack.back();
+                stack.pop_back();
+                object.push_back(cell);
+                for (int dy = -2; dy <= 2; dy++) {
+                    for (int dx = -2; dx <= 2; dx++) {
+                        int nx = cell.first + dx, ny = cell.second + dy;
+                        int wx = nx, wy = ny;
+                        if (torodial) {
+                            wx = ((nx % width) + width) % width;
+                            wy = ((ny % height) + height) % height;
+                        }
+                        else if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+                            continue;
+                        }
+                        if (state.row(wy)[wx] == Cell::ALIVE && !seen[(size_t)wy * width + wx]) {
+                            seen[(size_t)wy * width + wx] = 1;
+                            stack.push_back({nx, ny});
+                        }
+                    }
+                }
+            }
+            objects.push_back(object);
+        }
+    }
+    return objects;
+}
+
+/**
+ * Census::add_state(state, toroidal, tally)
+ *
+ * Private helper which separates a world into objects and counts their names into a tally.
+ * Each group found by Census::separate(state, toroidal) is split into its independent parts first.
+ */
+void Census::add_state(const Grid &state, const bool torodial, std::map<std::string, unsigned long long> &tally) {
+    for (const Cells &group : Census::separate(state, torodial)) {
+        for (const Cells &part : this->split(group)) {
+            tally[this->get_object(part).name]++;
+        }
+    }
+}
+
+/**
+ * Census::remove_escapees(state, toroidal, outskirts, tally)
+ *
+ * Private helper which removes the spaceships escaping from the middle of a world, counting their names into a
+ * tally. On a torus, or against the edges of a bounded world, a spaceship which escaped would otherwise come back
+ * and crash into what it left behind, which it never does on the unbounded plane.
+ *
+ * Only the groups of up to ESCAPE_CELLS cells with a cell past ESCAPE_RADIUS of the middle are looked at, grown
+ * from those cells as Census::separate(state, toroidal) would, so the ash in the middle is never separated. Such a
+ * group is a spaceship escaping once it moves away from the middle, no other alive cell is within ESCAPE_DISTANCE
+ * cells of it, and no cell further out is in the lane it travels along.
+ *
+ * The outskirts of the world at the last look are kept from one look to the next. A world whose cells past the
+ * middle have not changed is not looked at again, and a group is only named once its shape was also alone at the
+ * last look, so the fragments of a soup still settling are not analysed. Whether a spaceship is removed depends on
+ * its own soup alone, never on what the other soups of the census have named, so a census reproduces the same
+ * counts from the same seed on any number of threads.
+ *
+ * Looking every ESCAPE_INTERVAL generations makes a census about 3 times slower than advancing the soups in one
+ * go, in exchange for counting the gliders and spaceships which would otherwise crash into their own ash.
+ *
+ * @return
+ *      True if any spaceship was removed.
+ */
+bool Census::remove_escapees(Grid &state, const bool torodial, Outskirts &outskirts,
+    std::map<std::string, unsigned long long> &tally) {
+    const int width = (int)state.get_width();
+    const int height = (int)state.get_height();
+    const double middle_x = width / 2.0, middle_y = height / 2.0;
+    const double radius = std::min(width, height) * ESCAPE_RADIUS;
+    auto wrap = [](double offset, const int size) {
+        offset = std::fmod(offset, size);
+        offset += offset < -size / 2.0 ? size : 0;
+        offset -= offset >= size / 2.0 ? size : 0;
+        return offset;
+    };
+    // The index of a cell, wrapped on a torus, or -1 past the edges of a bounded world
+    auto index_of = [&](int x, int y) -> long {
+        if (x >= 0 && y >= 0 && x < width && y < height) {
+            return (long)y * width + x;
+        }
+        if (!torodial) {
+            return -1;
+        }
+        return (long)(((y % height) + height) % height) * width + ((x % width) + width) % width;
+    };
+
+    Cell *cells = state.data();
+
+    // The cells past the middle, which are not looked at again if they are the same as at the last look
+    Cells outside;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int y = 0; y < height; y++) {
+        const bool inside_y = std::abs(y + 0.5 - middle_y) <= radius;
+        for (int x = 0; x < width; x++) {
+            if (cells[(size_t)y * width + x] == Cell::ALIVE && (!inside_y || std::abs(x + 0.5 - middle_x) > radius)) {
+                outside.push_back({x, y});
+                hash = (hash ^ ((uint64_t)y * width + x)) * 0x100000001b3ULL;
+            }
+        }
+    }
+    if (hash == outskirts.hash) {
+        return false;
+    }
+    outskirts.hash = hash;
+
+    // Cells of the group being grown are marked 2, and cells already looked at 1
+    std::vector<unsigned char> seen((size_t)width * height, 0);
+    std::set<std::string> shapes;
+    bool removed = false;
+    Cells stack;
+    for (const auto &start : outside) {
+        const int x = start.first, y = start.second;
+        if (seen[(size_t)y * width + x]) {
+            continue;
+        }
+
+        // Grow the group, giving up once it is too large or reaches a group already given up on
+        Cells part;
+        bool large = false;
+        seen[(size_t)y * width + x] = 2;
+        stack.push_back({x, y});
+        while (!stack.empty() && !large) {
+            const std::pair<int, int> cell = stack.back();
+            stack.pop_back();
+            part.push_back(cell);
+            large = part.size() > ESCAPE_CELLS;
+            const bool within = cell.first >= 2 && cell.second >= 2 && cell.first < width - 2 &&
+                cell.second < height - 2;
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    const long index = within ? (long)(cell.second + dy) * width + cell.first + dx :
+                        index_of(cell.first + dx, cell.second + dy);
+                    if (index < 0 || cells[index] != Cell::ALIVE) {
+                        continue;
+                    }
+                    large = large || seen[index] == 1;
+                    if (!seen[index]) {
+                        seen[index] = 2;
+                        stack.push_back({cell.first + dx, cell.second + dy});
+                    }
+                }
+            }
+        }
+        part.insert(part.end(), stack.begin(), stack.end());
+        stack.clear();
+
+        // The centre of the group, and whether any other alive cell is near it
+        double centre_x = 0, centre_y = 0;
+        for (const auto &cell : part) {
+            centre_x += cell.first + 0.5;
+            centre_y += cell.second + 0.5;
+        }
+        centre_x /= part.size();
+        centre_y /= part.size();
+        bool alone = !large;
+        const int x0 = (int)std::floor(centre_x - ESCAPE_DISTANCE), y0 = (int)std::floor(centre_y - ESCAPE_DISTANCE);
+        for (int ny = y0; ny <= y0 + 2 * ESCAPE_DISTANCE && alone; ny++) {
+            for (int nx = x0; nx <= x0 + 2 * ESCAPE_DISTANCE && alone; nx++) {
+                const long index = index_of(nx, ny);
+                alone = index < 0 || std::abs(nx + 0.5 - centre_x) >= ESCAPE_DISTANCE ||
+                    std::abs(ny + 0.5 - centre_y) >= ESCAPE_DISTANCE || seen[index] == 2 || cells[index] != Cell::ALIVE;
+            }
+        }
+
+        bool escaping = false;
+        Object object;
+        if (alone) {
+            const std::string shape = encode(normalise(part));
+            shapes.insert(shape);
+            if (outskirts.shapes.count(shape) > 0) {
+                object = this->get_object(part);
+                escaping = object.dx != 0 || object.dy != 0;
+            }
+        }
+
+        // A spaceship is only escaping while it moves away from the middle with nothing ahead of it
+        if (escaping) {
+            double from_x = centre_x - middle_x, from_y = centre_y - middle_y;
+            if (torodial) {
+                from_x = wrap(from_x, width);
+                from_y = wrap(from_y, height);
+            }
+            const double outward = from_x * object.dx + from_y * object.dy;
+            const double length = std::sqrt((double)object.dx * object.dx + object.dy * object.dy);
+            escaping = outward > 0;
+            for (int ny = 0; ny < height && escaping; ny++) {
+                for (int nx = 0; nx < width && escaping; nx++) {
+                    if (cells[(size_t)ny * width + nx] != Cell::ALIVE || seen[(size_t)ny * width + nx] == 2) {
+                        continue;
+                    }
+                    double cell_x = nx + 0.5 - middle_x, cell_y = ny + 0.5 - middle_y;
+                    if (torodial) {
+                        cell_x = wrap(cell_x, width);
+                        cell_y = wrap(cell_y, height);
+                    }
+                    // Only a cell in the lane the spaceship travels along is in its way
+                    const double along = cell_x * object.dx + cell_y * object.dy;
+                    const double across = std::abs((cell_x - from_x) * object.dy - (cell_y - from_y) * object.dx);
+                    escaping = along < outward || across >= ESCAPE_DISTANCE * length;
+                }
+            }
+        }
+
+        for (const auto &cell : part) {
+            const long index = index_of(cell.first, cell.second);
+            seen[index] = 1;
+            if (escaping) {
+                cells[index] = Cell::DEAD;
+            }
+        }
+        if (escaping) {
+            tally[object.name]++;
+            removed = true;
+        }
+    }
+    outskirts.shapes.swap(shapes);
+    return removed;
+}
+
+/**
+ * Census::add_tally(tally, soups)
+ *
+ * Private helper which adds the counts of some soups to the census, from any thread.
+ */
+void Census::add_tally(const std::map<std::string, unsigned long long> &tally, const unsigned long long soups) {
+    std::lock_guard<std::mutex> lock(this->counts_mutex);
+    for (const auto &count : tally) {
+        this->counts[count.first] += count.second;
+    }
+    this->soups += soups;
+}
+
+/**
+ * Census::for_each_chunk(count, chunk)
+ *
+ * Private helper which splits count worlds into chunks of CHUNK_SIZE and invokes chunk(i0, i1) for each chunk
+ * [i0, i1) on the thread pool, returning once every chunk is done.
+ */
+void Census::for_each_chunk(const unsigned int count, const std::function<void(unsigned int, unsigned int)> &chunk) {
+    const unsigned int chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    auto run_chunk = [&](unsigned int index) {
+        chunk(index * CHUNK_SIZE, std::min(count, (index + 1) * CHUNK_SIZE));
+    };
+    if (!this->pool || chunks <= 1) {
+        for (unsigned int index = 0; index < chunks; index++) {
+            run_chunk(index);
+        }
+        return;
+    }
+    this->pool->run(chunks, run_chunk);
+}
+
+/**
+ * Census::add(state, toroidal)
+ *
+ * Count the objects of one world, as one soup.
+ *
+ * @param state
+ *      The world, usually after it has settled.
+ *
+ * @param toroidal
+ *      Optional parameter. If true objects can wrap across the edges of the world. Defaults to false.
+ */
+void Census::add(const Grid &state, const bool torodial) {
+    std::map<std::string, unsigned long long> tally;
+    this->add_state(state, torodial, tally);
+    this->add_tally(tally, 1);
+}
+
+/**
+ * Census::add(batch, toroidal)
+ *
+ * Count the objects of every world of a batch, each as one soup. The worlds are split into chunks of 64 which
+ * the threads take in turn, see Census::set_threads(threads).
+ *
+ * @param batch
+ *      The worlds, usually after they have been advanced until they terminate.
+ *
+ * @param toroidal
+ *      Optional parameter. If true objects can wrap across the edges of the worlds. Defaults to false.
+ */
+void Census::add(const WorldBatch &batch, const bool torodial) {
+    this->for_each_chunk(batch.get_count(), [&](unsigned int i0, unsigned int i1) {
+        std::map<std::string, unsigned long long> tally;
+        for (unsigned int i = i0; i < i1; i++) {
+            this->add_state(batch.get_state(i), torodial, tally);
+        }
+        this->add_tally(tally, i1 - i0);
+    });
+}
+
+/**
+ * Census::search(batch, generations, toroidal)
+ *
+ * Advance a batch of soups, each in the middle of its world, until they terminate or have run for a number of
+ * generations, then count the objects of every world, each as one soup. Every ESCAPE_INTERVAL generations the
+ * spaceships escaping from each world still running are removed and counted, so they cannot come back and
+ * crash into the ash they left, see Census::remove_escapees(state, toroidal, outskirts, tally). A world a spaceship was
+ * removed from starts looking for a cycle again, see WorldBatch::set_state(index, grid).
+ *
+ * @example
+ *
+ *      // Count the objects left by a 1000 soups on 64x64 tori
+ *      Census census;
+ *      WorldBatch batch(1000, 64);
+ *      batch.set_cycle_detection(30);
+ *      batch.randomize(1, 0, 0.5, 24, 24, 40, 40);
+ *      census.search(batch, 4096, true);
+ *
+ * @param batch
+ *      The worlds, with their soups in place.
+ *
+ * @param generations
+ *      The most generations to run each soup for.
+ *
+ * @param toroidal
+ *      Optional parameter. If true the worlds are tori. Defaults to false.
+ */
+void Census::search(WorldBatch &batch, const unsigned long long generations, const bool torodial) {
+    std::vector<Outskirts> outskirts(batch.get_count(), Outskirts{0, {}});
+    for (unsigned long long done = 0; done < generations && batch.get_running() > 0; done += ESCAPE_INTERVAL) {
+        batch.advance(std::min<unsigned long long>(ESCAPE_INTERVAL, generations - done), torodial);
+        this->for_each_chunk(batch.get_count(), [&](unsigned int i0, unsigned int i1) {
+            std::map<std::string, unsigned long long> tally;
+            for (unsigned int i = i0; i < i1; i++) {
+                if (batch.is_terminated(i)) {
+                    continue;
+                }
+                Grid state = batch.get_state(i);
+                if (this->remove_escapees(state, torodial, outskirts[i], tally)) {
+                    batch.set_state(i, state);
+                }
+            }
+            this->add_tally(tally, 0);
+        });
+    }
+    this->add(batch, torodial);
+}
+
+/**
+ * Census::get_soups()
+ *
+ * Gets the number of worlds counted.
+ *
+ * @return
+ *      The number of soups added.
+ */
+unsigned long long Census::get_soups() const {
+    return this->soups;
+}
+
+/**
+ * Census::get_counts()
+ *
+ * Gets the number of each object counted, most common first.
+ *
+ * @return
+ *      Pairs of the name of an object and how many were counted, ordered by count and then by name.
+ */
+std::vector<std::pair<std::string, unsigned long long>> Census::get_counts() const {
+    std::vector<std::pair<std::string, unsigned long long>> counts(this->counts.begin(), this->counts.end());
+    std::stable_sort(counts.begin(), counts.end(),
+        [](const std::pair<std::string, unsigned long long> &a, const std::pair<std::string, unsigned long long> &b) {
+            return a.second > b.second;
+        });
+    return counts;
+}
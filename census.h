@@ -0,0 +1,79 @@
+/**
+ * Declares a class which tallies the objects left behind by soups of the Game of Life.
+ * Rich documentation for the api and behaviour the Census class can be found in census.cpp.
+ */
+#pragma once
+#include "grid.h"
+#include "rule.h"
+#include "threadpool.h"
+#include "world_batch.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <functional>
+#include <cstdint>
+
+/**
+ * Declare the structure of the Census class for separating worlds into objects and counting them by name.
+ *
+ * Objects are named by their canonical hash, which is the same for every phase, rotation, reflection and position
+ * of an object, so a blinker counts as a blinker whichever way up it settled. Hashes found in the table of known
+ * objects get its name, the others a name built from how they behave and their hash.
+ */
+class Census {
+    private:
+        // An object as counted by the census, with how far it moves each period, 0 unless it is a spaceship
+        struct Object {
+            std::string name;
+            int dx;
+            int dy;
+        };
+
+        // What was seen past the middle of a world at the last look for escaping spaceships
+        struct Outskirts {
+            uint64_t hash;
+            std::set<std::string> shapes;
+        };
+
+        Rule rule;
+        unsigned int max_period;
+        std::map<uint64_t, std::string> known;
+        // The objects and the parts of groups already seen, keyed by their encoded shape
+        std::unordered_map<std::string, Object> objects;
+        std::unordered_map<std::string, std::vector<std::vector<std::pair<int, int>>>> parts;
+        std::mutex cache_mutex;
+        std::map<std::string, unsigned long long> counts;
+        unsigned long long soups;
+        std::mutex counts_mutex;
+        std::shared_ptr<ThreadPool> pool;
+
+        Object get_object(const std::vector<std::pair<int, int>> &cells);
+        std::vector<std::vector<std::pair<int, int>>> split(const std::vector<std::pair<int, int>> &cells);
+        void add_state(const Grid &state, const bool torodial, std::map<std::string, unsigned long long> &tally);
+        bool remove_escapees(Grid &state, const bool torodial, Outskirts &outskirts,
+            std::map<std::string, unsigned long long> &tally);
+        void add_tally(const std::map<std::string, unsigned long long> &tally, const unsigned long long soups);
+        void for_each_chunk(const unsigned int count, const std::function<void(unsigned int, unsigned int)> &chunk);
+
+    public:
+        explicit Census(const Rule &rule = Rule(), const unsigned int max_period = 30);
+
+        void add_known(const std::string &name, const Grid &pattern);
+        uint64_t get_canonical_hash(const Grid &pattern) const;
+        std::string classify(const Grid &pattern);
+        unsigned int get_threads() const;
+        void set_threads(const unsigned int threads);
+        void add(const Grid &state, const bool torodial = false);
+        void add(const WorldBatch &batch, const bool torodial = false);
+        void search(WorldBatch &batch, const unsigned long long generations, const bool torodial = false);
+        unsigned long long get_soups() const;
+        std::vector<std::pair<std::string, unsigned long long>> get_counts() const;
+
+        static std::vector<std::vector<std::pair<int, int>>> separate(const Grid &state, const bool torodial = false);
+
+};
@@ -0,0 +1,347 @@
+/**
+ * Implements a class which writes checkpoints of a grid to disk on a background thread.
+ *      - Checkpoints are tiled files, see Zoo::save_tiled(path, grid), named checkpoint-<step>.tgol.
+ *      - The rule of the run is written beside each checkpoint, in checkpoint-<step>.tgol.rule, since the tiled
+ *        format only holds the cells.
+ *      - Each checkpoint and its rule are written to a temporary file, synced to disk and renamed into place,
+ *        then the directory is synced, so a checkpoint with the final name is always complete, even if the
+ *        program dies or the machine loses power while writing.
+ *      - Once a checkpoint is in place the one before it is removed, so a directory holds one checkpoint at a time.
+ *      - The first error from the writer thread is rethrown from the next call to submit or flush.
+ */
+#include "checkpoint_writer.h"
+#include "zoo.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * CheckpointWriter::CheckpointWriter(directory)
+ *
+ * Construct a writer which saves checkpoints into a directory, creating it if needed, and start its thread.
+ *
+ * @example
+ *
+ *      // Write a checkpoint of a world every 1000 steps
+ *      CheckpointWriter checkpoints("path/to/checkpoints", world.get_rule().to_string());
+ *      for (unsigned long long step = 1000; step <= 10000; step += 1000) {
+ *          world.advance(1000);
+ *          checkpoints.submit(world.get_state(), step);
+ *      }
+ *
+ * @param directory
+ *      The directory to write checkpoints into.
+ *
+ * @param rule
+ *      Optional parameter. The notation of the rule the grids are stepped with, written beside each checkpoint
+ *      to be read back with CheckpointWriter::load_rule(path). Defaults to "", which writes no rule.
+ *
+ * @throws
+ *      std::runtime_error if the directory cannot be created.
+ */
+CheckpointWriter::CheckpointWriter(const std::string &directory, const std::string &rule)
+    : directory(directory), rule(rule), pending_step(0), has_pending(false), writing(false), stopping(false) {
+    std::error_code code;
+    std::filesystem::create_directories(directory, code);
+    if (code) {
+        throw std::runtime_error("CheckpointWriter() : Directory cannot be created.");
+    }
+    //a checkpoint left by an earlier run is replaced by the first one written
+    unsigned long long step = 0;
+    CheckpointWriter::find_latest(directory, this->last_path, step);
+    this->writer = std::thread(&CheckpointWriter::writer_loop, this);
+}
+
+/**
+ * CheckpointWriter::~CheckpointWriter()
+ *
+ * Write the snapshot still waiting, if any, and join the writer thread.
+ * Errors are not reported here, call CheckpointWriter::flush() first to see them.
+ */
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->snapshot_ready.notify_one();
+    this->writer.join();
+}
+
+/**
+ * CheckpointWriter::submit(grid, step)
+ *
+ * Hand a snapshot of a grid to the writer thread and return without waiting for the disk.
+ * The grid is copied into a buffer reused between calls, which is the only work done on the calling thread.
+ * A snapshot still waiting to be written is replaced by this one.
+ *
+ * @param grid
+ *      The grid to checkpoint.
+ *
+ * @param step
+ *      The step the grid was reached at, which names the checkpoint.
+ *
+ * @throws
+ *      std::runtime_error if writing an earlier checkpoint failed.
+ */
+void CheckpointWriter::submit(const Grid &grid, const unsigned long long step) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->error) {
+            std::exception_ptr failed = this->error;
+            this->error = nullptr;
+            std::rethrow_exception(failed);
+        }
+        this->pending = grid;
+        this->pending_step = step;
+        this->has_pending = true;
+    }
+    this->snapshot_ready.notify_one();
+}
+
+/**
+ * CheckpointWriter::flush()
+ *
+ * Wait until every submitted snapshot has been written.
+ *
+ * @throws
+ *      std::runtime_error if writing a checkpoint failed.
+ */
+void CheckpointWriter::flush() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->snapshot_written.wait(lock, [this] { return !this->has_pending && !this->writing; });
+    if (this->error) {
+        std::exception_ptr failed = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(failed);
+    }
+}
+
+/**
+ * CheckpointWriter::get_path(directory, step)
+ *
+ * Gets the path of the checkpoint for a step.
+ *
+ * @param directory
+ *      The directory holding the checkpoints.
+ *
+ * @param step
+ *      The step of the checkpoint.
+ *
+ * @return
+ *      The path of the checkpoint file.
+ */
+std::string CheckpointWriter::get_path(const std::string &directory, const unsigned long long step) {
+    return (std::filesystem::path(directory) / ("checkpoint-" + std::to_string(step) + ".tgol")).string();
+}
+
+/**
+ * CheckpointWriter::find_latest(directory, path, step)
+ *
+ * Find the newest complete checkpoint in a directory, the one with the highest step.
+ * Temporary files left by an interrupted write are ignored.
+ *
+ * @example
+ *
+ *      // Resume from the newest checkpoint, if there is one
+ *      std::string path;
+ *      unsigned long long step = 0;
+ *      if (CheckpointWriter::find_latest("path/to/checkpoints", path, step)) {
+ *          World world(Zoo::load_tiled(path));
+ *      }
+ *
+ * @param directory
+ *      The directory holding the checkpoints.
+ *
+ * @param path
+ *      Set to the path of the newest checkpoint, if one was found.
+ *
+ * @param step
+ *      Set to the step of the newest checkpoint, if one was found.
+ *
+ * @return
+ *      True if a checkpoint was found, false if there is none or the directory does not exist.
+ */
+bool CheckpointWriter::find_latest(const std::string &directory, std::string &path, unsigned long long &step) {
+    const std::string prefix = "checkpoint-";
+    const std::string suffix = ".tgol";
+    bool found = false;
+    std::error_code code;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, code)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        const std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        const unsigned long long parsed = std::stoull(digits);
+        if (!found || parsed > step) {
+            found = true;
+            step = parsed;
+            path = entry.path().string();
+        }
+    }
+    return found;
+}
+
+/**
+ * CheckpointWriter::get_rule_path(path)
+ *
+ * Gets the path of the file holding the rule of a checkpoint.
+ *
+ * @param path
+ *      The path of the checkpoint file.
+ *
+ * @return
+ *      The path of its rule file.
+ */
+std::string CheckpointWriter::get_rule_path(const std::string &path) {
+    return path + ".rule";
+}
+
+/**
+ * CheckpointWriter::load_rule(path)
+ *
+ * Read the rule a checkpoint was stepped with, so a resumed run carries on under the same rule.
+ *
+ * @example
+ *
+ *      // Resume from the newest checkpoint under its own rule
+ *      std::string path;
+ *      unsigned long long step = 0;
+ *      if (CheckpointWriter::find_latest("path/to/checkpoints", path, step)) {
+ *          World world(Zoo::load_tiled(path));
+ *          const std::string rule = CheckpointWriter::load_rule(path);
+ *          if (!rule.empty()) {
+ *              world.set_rule(Rule(rule));
+ *          }
+ *      }
+ *
+ * @param path
+ *      The path of the checkpoint file.
+ *
+ * @return
+ *      The notation of the rule, or "" if the checkpoint was written without one.
+ */
+std::string CheckpointWriter::load_rule(const std::string &path) {
+    std::ifstream file(CheckpointWriter::get_rule_path(path));
+    std::string rule;
+    std::getline(file, rule);
+    return rule;
+}
+
+/**
+ * sync_path(path)
+ *
+ * Flush a file or directory to disk with fsync, so a crash cannot lose what was written to it or renamed in it.
+ *
+ * @return
+ *      True if it was flushed.
+ */
+static bool sync_path(const std::string &path) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    const bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    return synced;
+}
+
+/**
+ * write_in_place(temporary, path, what)
+ *
+ * Sync a file written to a temporary path, rename it into place and sync the directory holding it.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be synced or renamed, naming what it holds.
+ */
+static void write_in_place(const std::string &temporary, const std::string &path, const std::string &what) {
+    if (!sync_path(temporary)) {
+        throw std::runtime_error("CheckpointWriter::write() : " + what + " cannot be synced to disk.");
+    }
+    std::error_code code;
+    std::filesystem::rename(temporary, path, code);
+    if (code) {
+        throw std::runtime_error("CheckpointWriter::write() : " + what + " cannot be renamed into place.");
+    }
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (!sync_path(directory.empty() ? "." : directory.string())) {
+        throw std::runtime_error("CheckpointWriter::write() : " + what + " directory cannot be synced to disk.");
+    }
+}
+
+/**
+ * CheckpointWriter::writer_loop()
+ *
+ * Private helper run by the writer thread, which writes the latest snapshot each time one is submitted.
+ * The snapshot is swapped out of the shared buffer, so the lock is never held while writing.
+ */
+void CheckpointWriter::writer_loop() {
+    Grid snapshot;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->snapshot_ready.wait(lock, [this] { return this->has_pending || this->stopping; });
+        if (!this->has_pending) {
+            return;
+        }
+        std::swap(snapshot, this->pending);
+        const unsigned long long step = this->pending_step;
+        this->has_pending = false;
+        this->writing = true;
+        lock.unlock();
+
+        std::exception_ptr failed;
+        try {
+            this->write(snapshot, step);
+        }
+        catch (...) {
+            failed = std::current_exception();
+        }
+
+        lock.lock();
+        if (failed && !this->error) {
+            this->error = failed;
+        }
+        this->writing = false;
+        this->snapshot_written.notify_all();
+    }
+}
+
+/**
+ * CheckpointWriter::write(grid, step)
+ *
+ * Private helper which writes one checkpoint to a temporary file, syncs it and renames it into place, syncs the
+ * directory, and removes the previous checkpoint. The rule file is put in place the same way first, so a complete
+ * checkpoint always has it, see write_in_place(temporary, path, what).
+ *
+ * @throws
+ *      std::runtime_error if the checkpoint cannot be written, synced or renamed.
+ */
+void CheckpointWriter::write(const Grid &grid, const unsigned long long step) {
+    const std::string path = CheckpointWriter::get_path(this->directory, step);
+    const std::string temporary = path + ".tmp";
+    std::error_code code;
+    if (!this->rule.empty()) {
+        const std::string rule_path = CheckpointWriter::get_rule_path(path);
+        std::ofstream file(rule_path + ".tmp", std::ios::trunc);
+        file << this->rule << '\n';
+        file.close();
+        if (!file) {
+            throw std::runtime_error("CheckpointWriter::write() : Rule cannot be written.");
+        }
+        write_in_place(rule_path + ".tmp", rule_path, "Rule");
+    }
+    Zoo::save_tiled(temporary, grid);
+    write_in_place(temporary, path, "Checkpoint");
+
+    if (!this->last_path.empty() && this->last_path != path) {
+        std::filesystem::remove(this->last_path, code);
+        std::filesystem::remove(CheckpointWriter::get_rule_path(this->last_path), code);
+    }
+    this->last_path = path;
+}
@@ -0,0 +1,52 @@
+/**
+ * Declares a class which writes checkpoints of a grid to disk on a background thread.
+ * Rich documentation for the api and behaviour the CheckpointWriter class can be found in checkpoint_writer.cpp.
+ */
+#pragma once
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "grid.h"
+
+/**
+ * Declare the structure of the CheckpointWriter class for saving snapshots without blocking the simulation.
+ *
+ * Only the latest snapshot waits to be written. A snapshot submitted while an older one is still waiting
+ * replaces it, so a slow disk makes checkpoints less frequent rather than stalling the caller.
+ */
+class CheckpointWriter {
+    private:
+        std::string directory;
+        std::string rule;
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable snapshot_ready;
+        std::condition_variable snapshot_written;
+        Grid pending;
+        unsigned long long pending_step;
+        bool has_pending;
+        bool writing;
+        bool stopping;
+        std::exception_ptr error;
+        std::string last_path;
+
+        void writer_loop();
+        void write(const Grid &grid, const unsigned long long step);
+
+    public:
+        explicit CheckpointWriter(const std::string &directory, const std::string &rule = "");
+        ~CheckpointWriter();
+        CheckpointWriter(const CheckpointWriter &other) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter &other) = delete;
+
+        void submit(const Grid &grid, const unsigned long long step);
+        void flush();
+
+        static std::string get_path(const std::string &directory, const unsigned long long step);
+        static bool find_latest(const std::string &directory, std::string &path, unsigned long long &step);
+        static std::string get_rule_path(const std::string &path);
+        static std::string load_rule(const std::string &path);
+
+};
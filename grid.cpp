@@ -14,6 +14,9 @@
 #include "grid.h"
 #include <vector>
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 // Include the minimal number of headers needed to support your implementation.
 // #include ...
@@ -173,6 +176,7 @@ unsigned int Grid::get_total_cells() const {
  *
  * Counts how many cells in the grid are alive.
  * The function should be callable from a constant context.
+ * Cells are counted 8 at a time with a popcount.
  *
  * @example
  *
@@ -192,8 +196,18 @@ unsigned int Grid::get_total_cells() const {
  *      The number of alive cells.
  */
 unsigned int Grid::get_alive_cells() const {
+    // Cell::ALIVE ('#', 0x23) has its lowest bit set and Cell::DEAD (' ', 0x20) does not,
+    // so 8 cells at a time can be counted by masking the lowest bit of each byte and taking a popcount.
+    const size_t total = this->gridVector.size();
+    const char *cells = reinterpret_cast<const char*>(this->gridVector.data());
     unsigned int alive_counter = 0;
-    for (unsigned int i = 0; i < (this->height * this->width); i++) {
+    size_t i = 0;
+    for (; i + 8 <= total; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, cells + i, sizeof(word));
+        alive_counter += __builtin_popcountll(word & 0x0101010101010101ULL);
+    }
+    for (; i < total; i++) {
         if (gridVector[i] == Cell::ALIVE) {
             alive_counter++;
         }
@@ -226,13 +240,7 @@ unsigned int Grid::get_alive_cells() const {
  *      The number of dead cells.
  */
 unsigned int Grid::get_dead_cells() const {
-    unsigned int dead_counter = 0;
-    for (unsigned int i = 0; i < this->height * this->width; i++) {
-        if (gridVector[i] == Cell::DEAD) {
-            dead_counter++;
-        }
-    }
-    return dead_counter;
+    return this->get_total_cells() - this->get_alive_cells();
 }
 
 
@@ -280,13 +288,12 @@ void Grid::resize(const unsigned int square_size){
  *      The new height for the grid.
  */
 void Grid::resize(const unsigned int newWidth, const unsigned int newHeight) {
-    std::vector<Cell> newVec(newWidth * newHeight, Cell::DEAD);
-    
-    
+    std::vector<Cell> newVec((size_t)newWidth * newHeight, Cell::DEAD);
+    const unsigned int keptWidth = std::min(this->width, newWidth);
+
     for (unsigned int i = 0; i < this->height && i < newHeight; i++) {
-        for (unsigned int j = 0; j < this->width && j < newWidth; j++) {
-            newVec[get_index_new_grid(j,i,newWidth)] = this->gridVector[get_index(j, i)];
-        }
+        const Cell *oldRow = this->row(i);
+        std::copy(oldRow, oldRow + keptWidth, newVec.begin() + (size_t)get_index_new_grid(0, i, newWidth));
     }
     this->height = newHeight;
     this->width = newWidth;
@@ -468,6 +475,128 @@ Cell Grid::operator()(const unsigned int x, const unsigned int y) const {
     return this->gridVector[get_index(x, y)];
 }
 
+/**
+ * Grid::get_stride()
+ *
+ * Gets the distance in cells between the start of one row and the start of the next,
+ * for use with Grid::data(). Rows are stored contiguously, one after another.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Get the cell at (1, 2) without a bounds check
+ *      Cell cell = grid.data()[2 * grid.get_stride() + 1];
+ *
+ * @return
+ *      The number of cells from the start of one row to the start of the next.
+ */
+unsigned int Grid::get_stride() const {
+    return this->width;
+}
+
+/**
+ * Grid::data()
+ *
+ * Gets a read-only pointer to the first cell of the grid, the cell at (0, 0).
+ * Row y starts at data() + y * get_stride(). Nothing is bounds checked, this is the fast path for
+ * bulk operations which have already validated their ranges.
+ *
+ * The pointer is invalidated by Grid::resize(width, height).
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Count the alive cells in the whole grid
+ *      const Cell *cells = grid.data();
+ *      unsigned int alive = std::count(cells, cells + grid.get_total_cells(), Cell::ALIVE);
+ *
+ * @return
+ *      A read-only pointer to the first cell of the grid.
+ */
+const Cell* Grid::data() const {
+    return this->gridVector.data();
+}
+
+/**
+ * Grid::data()
+ *
+ * Gets a modifiable pointer to the first cell of the grid, the cell at (0, 0).
+ * Row y starts at data() + y * get_stride(). Nothing is bounds checked.
+ *
+ * The pointer is invalidated by Grid::resize(width, height).
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Set every cell alive
+ *      std::fill(grid.data(), grid.data() + grid.get_total_cells(), Cell::ALIVE);
+ *
+ * @return
+ *      A modifiable pointer to the first cell of the grid.
+ */
+Cell* Grid::data() {
+    return this->gridVector.data();
+}
+
+/**
+ * Grid::row(y)
+ *
+ * Gets a read-only pointer to the first cell of row y. The row is get_width() contiguous cells.
+ * Nothing is bounds checked, y must be less than get_height().
+ *
+ * The pointer is invalidated by Grid::resize(width, height).
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Read the cell at (1, 2)
+ *      Cell cell = grid.row(2)[1];
+ *
+ * @param y
+ *      The y coordinate of the row.
+ *
+ * @return
+ *      A read-only pointer to the cell at (0, y).
+ */
+const Cell* Grid::row(const unsigned int y) const {
+    return this->gridVector.data() + (size_t)y * this->width;
+}
+
+/**
+ * Grid::row(y)
+ *
+ * Gets a modifiable pointer to the first cell of row y. The row is get_width() contiguous cells.
+ * Nothing is bounds checked, y must be less than get_height().
+ *
+ * The pointer is invalidated by Grid::resize(width, height).
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Set the whole of row 2 alive
+ *      std::fill(grid.row(2), grid.row(2) + grid.get_width(), Cell::ALIVE);
+ *
+ * @param y
+ *      The y coordinate of the row.
+ *
+ * @return
+ *      A modifiable pointer to the cell at (0, y).
+ */
+Cell* Grid::row(const unsigned int y) {
+    return this->gridVector.data() + (size_t)y * this->width;
+}
+
 /**
  * Grid::crop(x0, y0, x1, y1)
  *
@@ -515,9 +644,8 @@ Grid Grid::crop(const unsigned int x0, const unsigned int y0, const unsigned int
     Grid newGrid = Grid(newWidth, newHeight);
 
     for (unsigned int y = y0; y < y1; y++) {
-        for (unsigned int x = x0; x < x1; x++) {
-            newGrid(x - x0, y - y0) = this->get(x, y);
-        }
+        const Cell *oldRow = this->row(y);
+        std::copy(oldRow + x0, oldRow + x1, newGrid.row(y - y0));
     }
 
     return newGrid;
@@ -567,16 +695,17 @@ void Grid::merge(const Grid other, const unsigned int x0, const unsigned int y0,
         throw std::invalid_argument("merge() : The other grid does not fit in this grid.");
     }
 
-    for (unsigned int y = y0; y < width && y < y0 + other.get_width(); y++) {
-        for (unsigned int x = x0; x < height && x < x0 + other.get_height(); x++) {
-            if (other(x - x0, y - y0) == Cell::ALIVE && alive_only) {
-                this->set(x, y, Cell::ALIVE);
-            }
-            else if(alive_only && this->get(x, y) == Cell::ALIVE){
-                this->set(x - x0, y - y0, Cell::ALIVE);
-            } else {
-                this->set(x, y, other(x - x0, y - y0));
+    for (unsigned int y = 0; y < other.get_height(); y++) {
+        const Cell *otherRow = other.row(y);
+        Cell *thisRow = this->row(y0 + y) + x0;
+        if (alive_only) {
+            for (unsigned int x = 0; x < other.get_width(); x++) {
+                if (otherRow[x] == Cell::ALIVE) {
+                    thisRow[x] = Cell::ALIVE;
+                }
             }
+        } else {
+            std::copy(otherRow, otherRow + other.get_width(), thisRow);
         }
     }
 }
@@ -614,12 +743,7 @@ Grid Grid::rotate(const int rotation) const {
     switch (realRotation) {
         case 0:
         {
-            Grid newGrid = Grid(this->width, this->height);
-            for (unsigned int y = 0; y < this->height; y++) {
-                for (unsigned int x = 0; x < this->width; x++) {
-                    newGrid(x, y) = this->get(x, y);
-                }
-            }
+            Grid newGrid = *this;
             return newGrid;
             break;
         }
@@ -628,8 +752,10 @@ Grid Grid::rotate(const int rotation) const {
         {
             Grid newGrid = Grid(this->height, this->width);
             for (unsigned int y = 0; y < this->height; y++) {
+                const Cell *oldRow = this->row(y);
+                Cell *column = newGrid.data() + (this->height - y - 1);
                 for (unsigned int x = 0; x < this->width; x++) {
-                    newGrid(this->height - y - 1, x) = this->get(x, y);
+                    column[(size_t)x * this->height] = oldRow[x];
                 }
             }
             return newGrid;
@@ -640,9 +766,8 @@ Grid Grid::rotate(const int rotation) const {
         {
             Grid newGrid = Grid(this->width, this->height);
             for (unsigned int y = 0; y < this->height; y++) {
-                for (unsigned int x = 0; x < this->width; x++) {
-                    newGrid(this->width - x - 1, this->height - y - 1) = this->get(x, y);
-                }
+                const Cell *oldRow = this->row(y);
+                std::reverse_copy(oldRow, oldRow + this->width, newGrid.row(this->height - y - 1));
             }
             return newGrid;
             break;
@@ -652,8 +777,10 @@ Grid Grid::rotate(const int rotation) const {
         {
             Grid newGrid = Grid(this->height, this->width);
             for (unsigned int y = 0; y < this->height; y++) {
+                const Cell *oldRow = this->row(y);
+                Cell *column = newGrid.data() + y;
                 for (unsigned int x = 0; x < this->width; x++) {
-                    newGrid(y, this->width - x - 1) = this->get(x, y);
+                    column[(size_t)(this->width - x - 1) * this->height] = oldRow[x];
                 }
             }
             return newGrid;
@@ -667,6 +794,46 @@ Grid Grid::rotate(const int rotation) const {
 }
 
 
+/**
+ * Grid::render(buffer)
+ *
+ * Render the grid wrapped in its border into a buffer, exactly as operator<<(output_stream, grid) prints it.
+ * The buffer is sized once and every row is copied into it whole, so passing the same buffer for every frame
+ * renders without allocating.
+ *
+ * @example
+ *
+ *      // Render a grid and write it in one go
+ *      std::string buffer;
+ *      grid.render(buffer);
+ *      std::cout.write(buffer.data(), buffer.size());
+ *
+ * @param buffer
+ *      The buffer to overwrite with the rendered grid, a newline follows every line including the last.
+ */
+void Grid::render(std::string &buffer) const {
+    const size_t line = (size_t)this->width + 3;
+    buffer.resize(line * ((size_t)this->height + 2));
+    char *out = &buffer[0];
+
+    //the top and bottom borders are the same line
+    char *top = out;
+    top[0] = '+';
+    std::fill(top + 1, top + 1 + this->width, '-');
+    top[this->width + 1] = '+';
+    top[this->width + 2] = '\n';
+    out += line;
+
+    for (unsigned int y = 0; y < this->height; y++) {
+        out[0] = '|';
+        std::copy(this->row(y), this->row(y) + this->width, out + 1);
+        out[this->width + 1] = '|';
+        out[this->width + 2] = '\n';
+        out += line;
+    }
+    std::copy(top, top + line, out);
+}
+
 /**
  * operator<<(output_stream, grid)
  *
@@ -674,6 +841,9 @@ Grid Grid::rotate(const int rotation) const {
  * The grid is printed wrapped in a border of - (dash), | (pipe), and + (plus) characters.
  * Alive cells are shown as # (hash) characters, dead cells with ' ' (space) characters.
  *
+ * The whole frame is rendered into a reusable buffer, see Grid::render(buffer), and written with a single call,
+ * so printing does not flush the stream or go through the stream once per character.
+ *
  * The function should be callable on a constant Grid.
  *
  * @example
@@ -703,23 +873,10 @@ Grid Grid::rotate(const int rotation) const {
  *      Returns a reference to the output stream to enable operator chaining.
  */
 std::ostream& operator<<(std::ostream& lhs, const Grid& rhs) {
-    lhs << "+";
-    for (unsigned int i = 0; i < rhs.get_width(); i++) {
-        lhs << "-";
-    }
-    lhs << "+" << std::endl;
-    for (unsigned int y = 0; y < rhs.get_height(); y++) {
-        lhs << "|";
-        for (unsigned int x = 0; x < rhs.get_width(); x++) {
-            lhs << (char) rhs(x, y);
-        }
-        lhs << "|" << std::endl;
-    }
-    lhs << "+";
-    for (unsigned int i = 0; i < rhs.get_width(); i++) {
-        lhs << "-";
-    }
-    lhs << "+" << std::endl;
+    // Reused between calls so printing every step does not allocate
+    static thread_local std::string buffer;
+    rhs.render(buffer);
+    lhs.write(buffer.data(), buffer.size());
     return lhs;
 }
 
@@ -11,6 +11,7 @@
 #pragma once
 #include <vector>
 #include <iostream>
+#include <string>
 
 // Add the minimal number of includes you need in order to declare the class.
 // #include ...
@@ -58,9 +59,15 @@ class Grid {
         void set(const unsigned int x, const unsigned int y, Cell cell);
         Cell operator()(const unsigned int x, const unsigned int y) const;
         Cell& operator()(const unsigned int x, const unsigned int y);
+        unsigned int get_stride() const;
+        const Cell* data() const;
+        Cell* data();
+        const Cell* row(const unsigned int y) const;
+        Cell* row(const unsigned int y);
         Grid crop(const unsigned int x0, const unsigned int y0, const unsigned int x1, const unsigned int y1) const;
         void merge(const Grid other, const unsigned int x0, const unsigned int y0, const bool alive_only = false);
         Grid rotate(const int rotation) const;
+        void render(std::string &buffer) const;
 
         friend std::ostream& operator<<(std::ostream& lhs, const Grid& rhs);
 
@@ -0,0 +1,480 @@
+/**
+ * Implements a class for Bill Gosper's HashLife algorithm for the Game of Life.
+ *      - https://en.wikipedia.org/wiki/Hashlife
+ *
+ *      - The unbounded plane is stored as a quadtree. A node of level k is a square of 2^k by 2^k cells,
+ *        made of four nodes of level k - 1. Level 0 nodes are single dead or alive cells.
+ *          - Nodes are canonical: two nodes with the same four children are the same node, so any region
+ *            that repeats in space, including all empty space, is stored once.
+ *
+ *      - The RESULT of a node of level k is the node of level k - 1 at its centre, 2^(k - 2) generations later.
+ *          - This is computed recursively from the results of its sub-nodes, and memoized on the node,
+ *            so any region that repeats in time is only ever computed once.
+ *          - Smaller jumps of 2^j generations (j < k - 2) use the same recursion without advancing
+ *            in the first half, and are memoized in a separate table.
+ *
+ *      - HashLife simulates the unbounded plane, there is no toroidal topology and no bounded edge.
+ *        Grids are windows onto the plane, with (0, 0) being the top left cell of the initial Grid.
+ *
+ *      - Nodes are never freed while the HashLife object is alive.
+ */
+#include "hashlife.h"
+#include <stdexcept>
+
+/**
+ * HashLife::HashLife(rule = B3/S23)
+ *
+ * Construct an empty plane at generation 0.
+ *
+ * @example
+ *
+ *      // Make an empty plane
+ *      HashLife life;
+ *
+ *      // Make an empty plane for HighLife
+ *      HashLife highlife(Rule("B36/S23"));
+ *
+ * @param rule
+ *      Optional parameter. The rule to simulate, defaults to B3/S23.
+ *
+ * @throws
+ *      std::invalid_argument if the rule gives birth to cells with 0 neighbours,
+ *      as every cell of the unbounded plane would come alive.
+ */
+HashLife::HashLife(const Rule &rule) : origin_x(0), origin_y(0), generation(0), rule(rule) {
+    if (rule.get_birth() & 1) {
+        throw std::invalid_argument("HashLife() : Rules with birth on 0 neighbours cannot run on the unbounded plane.");
+    }
+    this->nodes.push_back(Node{nullptr, nullptr, nullptr, nullptr, 0, 0, nullptr});
+    this->dead_leaf = &this->nodes.back();
+    this->nodes.push_back(Node{nullptr, nullptr, nullptr, nullptr, 0, 1, nullptr});
+    this->alive_leaf = &this->nodes.back();
+    this->empty_nodes.push_back(this->dead_leaf);
+    this->root = this->empty(3);
+}
+
+/**
+ * HashLife::HashLife(grid, rule = B3/S23)
+ *
+ * Construct a plane at generation 0 containing the cells of a Grid, with the top left of the grid at (0, 0).
+ * Every cell outside of the grid is dead.
+ *
+ * @example
+ *
+ *      // Put an r-pentomino on the plane
+ *      HashLife life(Zoo::r_pentomino());
+ *
+ * @param grid
+ *      The initial cells.
+ *
+ * @param rule
+ *      Optional parameter. The rule to simulate, defaults to B3/S23.
+ *
+ * @throws
+ *      std::invalid_argument if the rule gives birth to cells with 0 neighbours.
+ */
+HashLife::HashLife(const Grid &grid, const Rule &rule) : HashLife(rule) {
+    unsigned int level = 3;
+    while (((int64_t)1 << level) < grid.get_width() || ((int64_t)1 << level) < grid.get_height()) {
+        level++;
+    }
+    this->root = this->build(grid, 0, 0, level);
+}
+
+/**
+ * HashLife::get_generation()
+ *
+ * Gets the number of generations the plane has been advanced by since construction.
+ *
+ * @return
+ *      The current generation.
+ */
+uint64_t HashLife::get_generation() const {
+    return this->generation;
+}
+
+/**
+ * HashLife::get_alive_cells()
+ *
+ * Gets the number of alive cells on the whole plane. The population is stored on every node,
+ * so this takes constant time.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+uint64_t HashLife::get_alive_cells() const {
+    return this->root->population;
+}
+
+/**
+ * HashLife::get_node_count()
+ *
+ * Gets the number of distinct nodes allocated so far, a measure of the memory in use.
+ *
+ * @return
+ *      The number of nodes.
+ */
+size_t HashLife::get_node_count() const {
+    return this->nodes.size();
+}
+
+/**
+ * HashLife::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate on the plane.
+ *
+ * @param x
+ *      The x coordinate of the cell, relative to the top left of the initial grid.
+ *
+ * @param y
+ *      The y coordinate of the cell, relative to the top left of the initial grid.
+ *
+ * @return
+ *      The value of the cell, Cell::ALIVE or Cell::DEAD.
+ */
+Cell HashLife::get(const int64_t x, const int64_t y) const {
+    const Node *node = this->root;
+    int64_t node_x = this->origin_x;
+    int64_t node_y = this->origin_y;
+    const int64_t size = (int64_t)1 << node->level;
+    if (x < node_x || y < node_y || x >= node_x + size || y >= node_y + size) {
+        return Cell::DEAD;
+    }
+    while (node->level > 0 && node->population > 0) {
+        const int64_t half = (int64_t)1 << (node->level - 1);
+        const bool east = x >= node_x + half;
+        const bool south = y >= node_y + half;
+        node = south ? (east ? node->se : node->sw) : (east ? node->ne : node->nw);
+        node_x += east ? half : 0;
+        node_y += south ? half : 0;
+    }
+    return node->population > 0 ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * HashLife::jump(step_log2)
+ *
+ * Advance the plane by exactly 2^step_log2 generations.
+ *
+ * The root is first padded with empty space until the pattern sits in its centre with a border wider than
+ * the furthest any cell could travel, then replaced by its (memoized) result.
+ *
+ * @example
+ *
+ *      // Advance a pattern by 2^40 generations
+ *      HashLife life(Zoo::glider());
+ *      life.jump(40);
+ *
+ * @param step_log2
+ *      The base 2 logarithm of the number of generations to advance by.
+ *
+ * @throws
+ *      std::invalid_argument if the jump would overflow the coordinates of the plane.
+ */
+void HashLife::jump(const unsigned int step_log2) {
+    if (step_log2 > 58) {
+        throw std::invalid_argument("jump() : Jump is too large.");
+    }
+    while (this->root->level < step_log2 + 2 || !this->is_padded(this->root)) {
+        this->root = this->expand(this->root);
+    }
+    this->root = this->expand(this->root);
+    if (this->root->level > 61) {
+        throw std::invalid_argument("jump() : Pattern is too large.");
+    }
+
+    const int64_t offset = (int64_t)1 << (this->root->level - 2);
+    this->root = this->successor(this->root, step_log2);
+    this->origin_x += offset;
+    this->origin_y += offset;
+    this->generation += (uint64_t)1 << step_log2;
+}
+
+/**
+ * HashLife::advance(steps)
+ *
+ * Advance the plane by any number of generations, as one jump per set bit of steps.
+ *
+ * @example
+ *
+ *      // Advance a pattern by a million generations
+ *      HashLife life(Zoo::r_pentomino());
+ *      life.advance(1000000);
+ *
+ * @param steps
+ *      The number of generations to advance by.
+ */
+void HashLife::advance(uint64_t steps) {
+    for (unsigned int step_log2 = 0; steps != 0; step_log2++, steps >>= 1) {
+        if (steps & 1) {
+            this->jump(step_log2);
+        }
+    }
+}
+
+/**
+ * HashLife::to_grid(x0, y0, width, height)
+ *
+ * Materialize a window of the plane as a Grid.
+ * Only non-empty nodes overlapping the window are visited.
+ *
+ * @example
+ *
+ *      // Advance a glider, which travels one cell diagonally every 4 generations
+ *      HashLife life(Zoo::glider());
+ *      life.advance(400);
+ *
+ *      // Extract the 3x3 window it has moved to
+ *      Grid grid = life.to_grid(100, 100, 3, 3);
+ *
+ * @param x0
+ *      The x coordinate of the top left of the window.
+ *
+ * @param y0
+ *      The y coordinate of the top left of the window.
+ *
+ * @param width
+ *      The width of the window.
+ *
+ * @param height
+ *      The height of the window.
+ *
+ * @return
+ *      A new Grid containing the cells in the window.
+ */
+Grid HashLife::to_grid(const int64_t x0, const int64_t y0, const unsigned int width, const unsigned int height) const {
+    Grid grid(width, height);
+    this->fill(grid, this->root, this->origin_x, this->origin_y, x0, y0);
+    return grid;
+}
+
+bool HashLife::NodeKey::operator==(const NodeKey &other) const {
+    return nw == other.nw && ne == other.ne && sw == other.sw && se == other.se;
+}
+
+size_t HashLife::NodeKeyHash::operator()(const NodeKey &key) const {
+    uint64_t hash = (uint64_t)(uintptr_t)key.nw;
+    hash = hash * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)key.ne;
+    hash = hash * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)key.sw;
+    hash = hash * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)key.se;
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+bool HashLife::StepKey::operator==(const StepKey &other) const {
+    return node == other.node && step_log2 == other.step_log2;
+}
+
+size_t HashLife::StepKeyHash::operator()(const StepKey &key) const {
+    const uint64_t hash = ((uint64_t)(uintptr_t)key.node * 0x9E3779B97F4A7C15ULL) + key.step_log2;
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+/**
+ * HashLife::join(nw, ne, sw, se)
+ *
+ * Private helper which returns the canonical node with the four given children, creating it if needed.
+ */
+const HashLife::Node* HashLife::join(const Node *nw, const Node *ne, const Node *sw, const Node *se) {
+    const NodeKey key{nw, ne, sw, se};
+    auto found = this->canonical.find(key);
+    if (found != this->canonical.end()) {
+        return found->second;
+    }
+    this->nodes.push_back(Node{nw, ne, sw, se, nw->level + 1,
+        nw->population + ne->population + sw->population + se->population, nullptr});
+    const Node *node = &this->nodes.back();
+    this->canonical.emplace(key, node);
+    return node;
+}
+
+/**
+ * HashLife::empty(level)
+ *
+ * Private helper which returns the canonical node of the given level with no alive cells.
+ */
+const HashLife::Node* HashLife::empty(const unsigned int level) {
+    while (this->empty_nodes.size() <= level) {
+        const Node *child = this->empty_nodes.back();
+        this->empty_nodes.push_back(this->join(child, child, child, child));
+    }
+    return this->empty_nodes[level];
+}
+
+/**
+ * HashLife::centre(node)
+ *
+ * Private helper which returns the node one level down made of the centre of the given node, at the same time.
+ */
+const HashLife::Node* HashLife::centre(const Node *node) {
+    return this->join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+}
+
+/**
+ * HashLife::expand(node)
+ *
+ * Private helper which returns the node one level up with the given node at its centre, surrounded by empty space.
+ * Updates the origin of the plane, so it must only be called on the root.
+ */
+const HashLife::Node* HashLife::expand(const Node *node) {
+    const Node *border = this->empty(node->level - 1);
+    this->origin_x -= (int64_t)1 << (node->level - 1);
+    this->origin_y -= (int64_t)1 << (node->level - 1);
+    return this->join(this->join(border, border, border, node->nw),
+                      this->join(border, border, node->ne, border),
+                      this->join(border, node->sw, border, border),
+                      this->join(node->se, border, border, border));
+}
+
+/**
+ * HashLife::is_padded(node)
+ *
+ * Private helper which checks that every alive cell of a node lies in the centre half of it (in each dimension),
+ * by checking the 12 grandchildren around its border are empty.
+ */
+bool HashLife::is_padded(const Node *node) const {
+    if (node->level < 3) {
+        return node->population == 0;
+    }
+    const uint64_t centre = node->nw->se->population + node->ne->sw->population +
+                            node->sw->ne->population + node->se->nw->population;
+    return centre == node->population;
+}
+
+/**
+ * HashLife::base_step(node)
+ *
+ * Private helper which computes the RESULT of a 4x4 (level 2) node directly:
+ * the centre 2x2 cells one generation later under the rule of the plane.
+ */
+const HashLife::Node* HashLife::base_step(const Node *node) {
+    bool cells[4][4];
+    for (unsigned int y = 0; y < 4; y++) {
+        for (unsigned int x = 0; x < 4; x++) {
+            const Node *quadrant = (y < 2) ? (x < 2 ? node->nw : node->ne) : (x < 2 ? node->sw : node->se);
+            const Node *leaf = (y % 2 == 0) ? (x % 2 == 0 ? quadrant->nw : quadrant->ne)
+                                            : (x % 2 == 0 ? quadrant->sw : quadrant->se);
+            cells[y][x] = leaf->population > 0;
+        }
+    }
+
+    const Node *next[4];
+    for (unsigned int i = 0; i < 4; i++) {
+        const unsigned int x = 1 + i % 2;
+        const unsigned int y = 1 + i / 2;
+        unsigned int neighbours = 0;
+        for (unsigned int dy = y - 1; dy <= y + 1; dy++) {
+            for (unsigned int dx = x - 1; dx <= x + 1; dx++) {
+                neighbours += cells[dy][dx];
+            }
+        }
+        neighbours -= cells[y][x];
+        const bool alive = this->rule.next(cells[y][x], neighbours);
+        next[i] = alive ? this->alive_leaf : this->dead_leaf;
+    }
+    return this->join(next[0], next[1], next[2], next[3]);
+}
+
+/**
+ * HashLife::successor(node, step_log2)
+ *
+ * Private helper which returns the centre of a node of level k, 2^step_log2 generations later,
+ * where step_log2 is at most k - 2.
+ *
+ * The node is split into 9 overlapping sub-nodes of level k - 1. At full speed (step_log2 = k - 2) each of them
+ * is advanced by half the time, reassembled into 4 nodes, and those are advanced by the other half.
+ * For smaller steps the first half takes the centres of the sub-nodes without advancing them.
+ */
+const HashLife::Node* HashLife::successor(const Node *node, const unsigned int step_log2) {
+    if (node->population == 0) {
+        return this->empty(node->level - 1);
+    }
+    if (node->level == 2) {
+        return this->base_step(node);
+    }
+
+    const bool full_speed = step_log2 == node->level - 2;
+    if (full_speed && node->result != nullptr) {
+        return node->result;
+    }
+    if (!full_speed) {
+        auto found = this->slow_results.find(StepKey{node, step_log2});
+        if (found != this->slow_results.end()) {
+            return found->second;
+        }
+    }
+
+    const Node *n00 = node->nw;
+    const Node *n01 = this->join(node->nw->ne, node->ne->nw, node->nw->se, node->ne->sw);
+    const Node *n02 = node->ne;
+    const Node *n10 = this->join(node->nw->sw, node->nw->se, node->sw->nw, node->sw->ne);
+    const Node *n11 = this->join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+    const Node *n12 = this->join(node->ne->sw, node->ne->se, node->se->nw, node->se->ne);
+    const Node *n20 = node->sw;
+    const Node *n21 = this->join(node->sw->ne, node->se->nw, node->sw->se, node->se->sw);
+    const Node *n22 = node->se;
+
+    const Node *r[9];
+    const Node *sub[9] = {n00, n01, n02, n10, n11, n12, n20, n21, n22};
+    for (unsigned int i = 0; i < 9; i++) {
+        r[i] = full_speed ? this->successor(sub[i], step_log2 - 1) : this->centre(sub[i]);
+    }
+
+    const unsigned int second_log2 = full_speed ? step_log2 - 1 : step_log2;
+    const Node *result = this->join(
+        this->successor(this->join(r[0], r[1], r[3], r[4]), second_log2),
+        this->successor(this->join(r[1], r[2], r[4], r[5]), second_log2),
+        this->successor(this->join(r[3], r[4], r[6], r[7]), second_log2),
+        this->successor(this->join(r[4], r[5], r[7], r[8]), second_log2));
+
+    if (full_speed) {
+        node->result = result;
+    }
+    else {
+        this->slow_results.emplace(StepKey{node, step_log2}, result);
+    }
+    return result;
+}
+
+/**
+ * HashLife::build(grid, x, y, level)
+ *
+ * Private helper which builds the node of the given level whose top left cell is grid(x, y).
+ * Cells outside of the grid are dead.
+ */
+const HashLife::Node* HashLife::build(const Grid &grid, const int64_t x, const int64_t y, const unsigned int level) {
+    if (x >= grid.get_width() || y >= grid.get_height()) {
+        return this->empty(level);
+    }
+    if (level == 0) {
+        return grid.row(y)[x] == Cell::ALIVE ? this->alive_leaf : this->dead_leaf;
+    }
+    const int64_t half = (int64_t)1 << (level - 1);
+    return this->join(this->build(grid, x, y, level - 1),
+                      this->build(grid, x + half, y, level - 1),
+                      this->build(grid, x, y + half, level - 1),
+                      this->build(grid, x + half, y + half, level - 1));
+}
+
+/**
+ * HashLife::fill(grid, node, node_x, node_y, x0, y0)
+ *
+ * Private helper which writes the alive cells of a node at (node_x, node_y) into a grid whose top left is (x0, y0).
+ */
+void HashLife::fill(Grid &grid, const Node *node, const int64_t node_x, const int64_t node_y,
+    const int64_t x0, const int64_t y0) const {
+    const int64_t size = (int64_t)1 << node->level;
+    if (node->population == 0 ||
+        node_x >= x0 + grid.get_width() || node_y >= y0 + grid.get_height() ||
+        node_x + size <= x0 || node_y + size <= y0) {
+        return;
+    }
+    if (node->level == 0) {
+        grid.row(node_y - y0)[node_x - x0] = Cell::ALIVE;
+        return;
+    }
+    const int64_t half = size / 2;
+    this->fill(grid, node->nw, node_x, node_y, x0, y0);
+    this->fill(grid, node->ne, node_x + half, node_y, x0, y0);
+    this->fill(grid, node->sw, node_x, node_y + half, x0, y0);
+    this->fill(grid, node->se, node_x + half, node_y + half, x0, y0);
+}
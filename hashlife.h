@@ -0,0 +1,91 @@
+/**
+ * Declares a class implementing Bill Gosper's HashLife algorithm for the Game of Life.
+ * Rich documentation for the api and behaviour the HashLife class can be found in hashlife.cpp.
+ */
+#pragma once
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the HashLife class for advancing a pattern on the unbounded plane
+ * by astronomically many generations.
+ *
+ * The plane is stored as a quadtree of canonical (hash consed) nodes. Identical regions share one node,
+ * and the future of each node is memoized, so repetitive patterns advance exponentially fast.
+ */
+class HashLife {
+    private:
+        struct Node {
+            const Node *nw;
+            const Node *ne;
+            const Node *sw;
+            const Node *se;
+            unsigned int level;
+            uint64_t population;
+            mutable const Node *result;
+        };
+
+        struct NodeKey {
+            const Node *nw;
+            const Node *ne;
+            const Node *sw;
+            const Node *se;
+            bool operator==(const NodeKey &other) const;
+        };
+
+        struct NodeKeyHash {
+            size_t operator()(const NodeKey &key) const;
+        };
+
+        struct StepKey {
+            const Node *node;
+            unsigned int step_log2;
+            bool operator==(const StepKey &other) const;
+        };
+
+        struct StepKeyHash {
+            size_t operator()(const StepKey &key) const;
+        };
+
+        std::deque<Node> nodes;
+        std::unordered_map<NodeKey, const Node*, NodeKeyHash> canonical;
+        std::unordered_map<StepKey, const Node*, StepKeyHash> slow_results;
+        std::vector<const Node*> empty_nodes;
+        const Node *dead_leaf;
+        const Node *alive_leaf;
+        const Node *root;
+        int64_t origin_x;
+        int64_t origin_y;
+        uint64_t generation;
+        Rule rule;
+
+        const Node* join(const Node *nw, const Node *ne, const Node *sw, const Node *se);
+        const Node* empty(const unsigned int level);
+        const Node* centre(const Node *node);
+        const Node* expand(const Node *node);
+        const Node* base_step(const Node *node);
+        const Node* successor(const Node *node, const unsigned int step_log2);
+        const Node* build(const Grid &grid, const int64_t x, const int64_t y, const unsigned int level);
+        bool is_padded(const Node *node) const;
+        void fill(Grid &grid, const Node *node, const int64_t node_x, const int64_t node_y,
+            const int64_t x0, const int64_t y0) const;
+
+    public:
+        explicit HashLife(const Rule &rule = Rule());
+        explicit HashLife(const Grid &grid, const Rule &rule = Rule());
+        HashLife(const HashLife &other) = delete;
+        HashLife& operator=(const HashLife &other) = delete;
+
+        uint64_t get_generation() const;
+        uint64_t get_alive_cells() const;
+        size_t get_node_count() const;
+        Cell get(const int64_t x, const int64_t y) const;
+        void jump(const unsigned int step_log2);
+        void advance(uint64_t steps);
+        Grid to_grid(const int64_t x0, const int64_t y0, const unsigned int width, const unsigned int height) const;
+
+};
@@ -0,0 +1,319 @@
+/**
+ * Implements a class representing a Larger than Life rule.
+ *      - The neighbourhood of a cell is the (2R + 1) x (2R + 1) square around it, for a radius R.
+ *      - The count of a cell is the number of alive cells in its neighbourhood, including the cell itself
+ *        only if the rule says so (M1), otherwise excluding it (M0).
+ *      - A dead cell is born if its count is within [birth_min, birth_max],
+ *        an alive cell survives if its count is within [survival_min, survival_max].
+ *
+ * Rules are parsed from and printed as the notation used by Golly, e.g. R5,C0,M1,S34..58,B34..45,NM for Bugs.
+ * Only 2 state rules (C0 or C2) and the Moore neighbourhood (NM) are supported.
+ *
+ * Rules: https://www.conwaylife.com/wiki/Larger_than_Life
+ */
+#include "larger_than_life.h"
+#include <cctype>
+#include <stdexcept>
+
+/**
+ * LargerThanLifeRule::LargerThanLifeRule(radius, birth_min, birth_max, survival_min, survival_max, middle = false)
+ *
+ * Construct a rule from its parameters.
+ *
+ * @example
+ *
+ *      // Make Bugs, R5,C0,M1,S34..58,B34..45,NM
+ *      LargerThanLifeRule bugs(5, 34, 45, 34, 58, true);
+ *
+ * @param radius
+ *      The radius of the neighbourhood, from 1 to LargerThanLifeRule::MAX_RADIUS.
+ *
+ * @param birth_min
+ *      The smallest count on which a dead cell is born.
+ *
+ * @param birth_max
+ *      The largest count on which a dead cell is born.
+ *
+ * @param survival_min
+ *      The smallest count on which an alive cell survives.
+ *
+ * @param survival_max
+ *      The largest count on which an alive cell survives.
+ *
+ * @param middle
+ *      Optional parameter. If true the count of a cell includes the cell itself. Defaults to false.
+ *
+ * @throws
+ *      std::invalid_argument if the radius is out of range, or a range is empty or larger than the neighbourhood.
+ */
+LargerThanLifeRule::LargerThanLifeRule(const unsigned int radius, const unsigned int birth_min,
+    const unsigned int birth_max, const unsigned int survival_min, const unsigned int survival_max, const bool middle)
+    : radius(radius), middle(middle), birth_min(birth_min), birth_max(birth_max),
+      survival_min(survival_min), survival_max(survival_max) {
+    if (radius < 1 || radius > MAX_RADIUS) {
+        throw std::invalid_argument("LargerThanLifeRule() : Radius out of range.");
+    }
+    const unsigned int cells = (2 * radius + 1) * (2 * radius + 1);
+    if (birth_min > birth_max || survival_min > survival_max || birth_max > cells || survival_max > cells) {
+        throw std::invalid_argument("LargerThanLifeRule() : Invalid birth or survival range.");
+    }
+}
+
+/**
+ * parse_number(text, position, name)
+ *
+ * Parse the decimal number starting at text[position], advancing position past it.
+ */
+static unsigned int parse_number(const std::string &text, size_t &position, const char *name) {
+    const size_t start = position;
+    unsigned long value = 0;
+    while (position < text.size() && std::isdigit((unsigned char)text[position])) {
+        value = value * 10 + (unsigned long)(text[position] - '0');
+        if (value > 0xFFFFFFFFul) {
+            throw std::invalid_argument(std::string("LargerThanLifeRule() : ") + name + " is out of range.");
+        }
+        position++;
+    }
+    if (position == start) {
+        throw std::invalid_argument(std::string("LargerThanLifeRule() : Missing a number for ") + name + ".");
+    }
+    return (unsigned int)value;
+}
+
+/**
+ * parse_range(text, min, max, name)
+ *
+ * Parse a range written as min..max, or a single number for a range of one count.
+ */
+static void parse_range(const std::string &text, unsigned int &min, unsigned int &max, const char *name) {
+    size_t position = 0;
+    min = parse_number(text, position, name);
+    max = min;
+    if (text.compare(position, 2, "..") == 0) {
+        position += 2;
+        max = parse_number(text, position, name);
+    }
+    if (position != text.size()) {
+        throw std::invalid_argument(std::string("LargerThanLifeRule() : Unexpected characters in ") + name + ".");
+    }
+}
+
+/**
+ * LargerThanLifeRule::LargerThanLifeRule(notation)
+ *
+ * Parse a rule from the notation used by Golly: comma separated fields R (radius), C (states, 0 or 2),
+ * M (1 to count the middle cell), S (survival range), B (birth range), and N (neighbourhood, M for Moore).
+ * R, S and B are required, the letters are case insensitive and the fields may come in any order.
+ *
+ * @example
+ *
+ *      // Make Bugs
+ *      LargerThanLifeRule bugs("R5,C0,M1,S34..58,B34..45,NM");
+ *
+ * @param notation
+ *      The rule in Larger than Life notation.
+ *
+ * @throws
+ *      std::invalid_argument if the notation cannot be parsed, or describes a rule which is not supported.
+ */
+LargerThanLifeRule::LargerThanLifeRule(const std::string &notation)
+    : radius(0), middle(false), birth_min(0), birth_max(0), survival_min(0), survival_max(0) {
+    bool seen_radius = false, seen_birth = false, seen_survival = false;
+    unsigned int radius = 0, birth_min = 0, birth_max = 0, survival_min = 0, survival_max = 0;
+    bool middle = false;
+
+    size_t start = 0;
+    while (start <= notation.size()) {
+        size_t end = notation.find(',', start);
+        if (end == std::string::npos) {
+            end = notation.size();
+        }
+        const std::string field = notation.substr(start, end - start);
+        start = end + 1;
+        if (field.empty()) {
+            throw std::invalid_argument("LargerThanLifeRule() : Empty field.");
+        }
+
+        const char letter = (char)std::toupper((unsigned char)field[0]);
+        const std::string value = field.substr(1);
+        size_t position = 0;
+        switch (letter) {
+            case 'R':
+                radius = parse_number(value, position, "R");
+                if (position != value.size()) {
+                    throw std::invalid_argument("LargerThanLifeRule() : Unexpected characters in R.");
+                }
+                seen_radius = true;
+                break;
+            case 'C':
+                if (value != "0" && value != "2") {
+                    throw std::invalid_argument("LargerThanLifeRule() : Only 2 state rules (C0 or C2) are supported.");
+                }
+                break;
+            case 'M':
+                if (value != "0" && value != "1") {
+                    throw std::invalid_argument("LargerThanLifeRule() : M must be 0 or 1.");
+                }
+                middle = value == "1";
+                break;
+            case 'S':
+                parse_range(value, survival_min, survival_max, "S");
+                seen_survival = true;
+                break;
+            case 'B':
+                parse_range(value, birth_min, birth_max, "B");
+                seen_birth = true;
+                break;
+            case 'N':
+                if (value != "M" && value != "m") {
+                    throw std::invalid_argument("LargerThanLifeRule() : Only the Moore neighbourhood (NM) is supported.");
+                }
+                break;
+            default:
+                throw std::invalid_argument("LargerThanLifeRule() : Unknown field.");
+        }
+    }
+
+    if (!seen_radius || !seen_birth || !seen_survival) {
+        throw std::invalid_argument("LargerThanLifeRule() : R, S and B are required.");
+    }
+    *this = LargerThanLifeRule(radius, birth_min, birth_max, survival_min, survival_max, middle);
+}
+
+/**
+ * LargerThanLifeRule::is_notation(notation)
+ *
+ * Tells Larger than Life notation apart from B/S notation, by the leading R and radius.
+ *
+ * @example
+ *
+ *      // true
+ *      LargerThanLifeRule::is_notation("R5,C0,M1,S34..58,B34..45,NM");
+ *
+ *      // false
+ *      LargerThanLifeRule::is_notation("B3/S23");
+ *
+ * @param notation
+ *      A rule in either notation.
+ *
+ * @return
+ *      True if the notation should be parsed as a Larger than Life rule.
+ */
+bool LargerThanLifeRule::is_notation(const std::string &notation) {
+    return notation.size() >= 2 && std::toupper((unsigned char)notation[0]) == 'R' &&
+        std::isdigit((unsigned char)notation[1]);
+}
+
+/**
+ * LargerThanLifeRule::get_radius()
+ *
+ * Gets the radius of the neighbourhood.
+ *
+ * @return
+ *      The radius R, the neighbourhood is (2R + 1) x (2R + 1) cells.
+ */
+unsigned int LargerThanLifeRule::get_radius() const {
+    return this->radius;
+}
+
+/**
+ * LargerThanLifeRule::get_middle()
+ *
+ * Gets if the count of a cell includes the cell itself.
+ *
+ * @return
+ *      True for M1 rules, false for M0 rules.
+ */
+bool LargerThanLifeRule::get_middle() const {
+    return this->middle;
+}
+
+/**
+ * LargerThanLifeRule::get_birth_min()
+ *
+ * @return
+ *      The smallest count on which a dead cell is born.
+ */
+unsigned int LargerThanLifeRule::get_birth_min() const {
+    return this->birth_min;
+}
+
+/**
+ * LargerThanLifeRule::get_birth_max()
+ *
+ * @return
+ *      The largest count on which a dead cell is born.
+ */
+unsigned int LargerThanLifeRule::get_birth_max() const {
+    return this->birth_max;
+}
+
+/**
+ * LargerThanLifeRule::get_survival_min()
+ *
+ * @return
+ *      The smallest count on which an alive cell survives.
+ */
+unsigned int LargerThanLifeRule::get_survival_min() const {
+    return this->survival_min;
+}
+
+/**
+ * LargerThanLifeRule::get_survival_max()
+ *
+ * @return
+ *      The largest count on which an alive cell survives.
+ */
+unsigned int LargerThanLifeRule::get_survival_max() const {
+    return this->survival_max;
+}
+
+/**
+ * LargerThanLifeRule::next(alive, count)
+ *
+ * Apply the rule to a single cell.
+ *
+ * @param alive
+ *      If the cell is alive now.
+ *
+ * @param count
+ *      The number of alive cells in the neighbourhood, including the cell itself only for M1 rules.
+ *
+ * @return
+ *      If the cell is alive in the next generation.
+ */
+bool LargerThanLifeRule::next(const bool alive, const unsigned int count) const {
+    if (alive) {
+        return count - this->survival_min <= this->survival_max - this->survival_min;
+    }
+    return count - this->birth_min <= this->birth_max - this->birth_min;
+}
+
+/**
+ * LargerThanLifeRule::to_string()
+ *
+ * Print the rule in the notation used by Golly.
+ *
+ * @example
+ *
+ *      // Prints R5,C0,M1,S34..58,B34..45,NM
+ *      std::cout << LargerThanLifeRule(5, 34, 45, 34, 58, true).to_string() << std::endl;
+ *
+ * @return
+ *      The rule in Larger than Life notation.
+ */
+std::string LargerThanLifeRule::to_string() const {
+    return "R" + std::to_string(this->radius) + ",C0,M" + (this->middle ? "1" : "0") +
+        ",S" + std::to_string(this->survival_min) + ".." + std::to_string(this->survival_max) +
+        ",B" + std::to_string(this->birth_min) + ".." + std::to_string(this->birth_max) + ",NM";
+}
+
+bool LargerThanLifeRule::operator==(const LargerThanLifeRule &other) const {
+    return this->radius == other.radius && this->middle == other.middle &&
+        this->birth_min == other.birth_min && this->birth_max == other.birth_max &&
+        this->survival_min == other.survival_min && this->survival_max == other.survival_max;
+}
+
+bool LargerThanLifeRule::operator!=(const LargerThanLifeRule &other) const {
+    return !(*this == other);
+}
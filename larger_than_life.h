@@ -0,0 +1,41 @@
+/**
+ * Declares a class representing a Larger than Life rule, a Life-like rule over a radius R neighbourhood.
+ * Rich documentation for the api and behaviour the LargerThanLifeRule class can be found in larger_than_life.cpp.
+ */
+#pragma once
+#include <string>
+
+/**
+ * Declare the structure of the LargerThanLifeRule class for representing a rule over the (2R + 1) x (2R + 1)
+ * Moore neighbourhood, where cells are born or survive when their neighbour count falls in a range.
+ */
+class LargerThanLifeRule {
+    private:
+        unsigned int radius;
+        bool middle;
+        unsigned int birth_min;
+        unsigned int birth_max;
+        unsigned int survival_min;
+        unsigned int survival_max;
+
+    public:
+        static const unsigned int MAX_RADIUS = 500;
+
+        LargerThanLifeRule(const unsigned int radius, const unsigned int birth_min, const unsigned int birth_max,
+            const unsigned int survival_min, const unsigned int survival_max, const bool middle = false);
+        explicit LargerThanLifeRule(const std::string &notation);
+
+        unsigned int get_radius() const;
+        bool get_middle() const;
+        unsigned int get_birth_min() const;
+        unsigned int get_birth_max() const;
+        unsigned int get_survival_min() const;
+        unsigned int get_survival_max() const;
+        bool next(const bool alive, const unsigned int count) const;
+        std::string to_string() const;
+        bool operator==(const LargerThanLifeRule &other) const;
+        bool operator!=(const LargerThanLifeRule &other) const;
+
+        static bool is_notation(const std::string &notation);
+
+};
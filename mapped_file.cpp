@@ -0,0 +1,90 @@
+/**
+ * Implements a class representing a read-only memory mapping of a whole file.
+ *      - The file is mapped with mmap, so its pages are read from disk (or the page cache) on first access,
+ *        and large files can be scanned at memory bandwidth without a copy through a stream buffer.
+ *      - The operating system is told the file will be read sequentially, so it reads ahead aggressively.
+ *      - An empty file maps to no memory, data() is nullptr and size() is 0.
+ */
+#include "mapped_file.h"
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * MappedFile::MappedFile(path)
+ *
+ * Map a whole file into memory, read-only.
+ *
+ * @example
+ *
+ *      // Map a checkpoint and read its first byte
+ *      MappedFile file("path/to/file.bgol");
+ *      unsigned char first = file.data()[0];
+ *
+ * @param path
+ *      The path to the file to map.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be opened or mapped.
+ */
+MappedFile::MappedFile(const std::string &path) : bytes(nullptr), length(0) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile() : File cannot be opened.");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("MappedFile() : File cannot be opened.");
+    }
+    this->length = (size_t)info.st_size;
+    if (this->length > 0) {
+        void *mapping = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("MappedFile() : File cannot be mapped.");
+        }
+        madvise(mapping, this->length, MADV_SEQUENTIAL);
+        this->bytes = static_cast<const unsigned char*>(mapping);
+    }
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+/**
+ * MappedFile::~MappedFile()
+ *
+ * Release the mapping.
+ */
+MappedFile::~MappedFile() {
+    if (this->bytes != nullptr) {
+        munmap(const_cast<unsigned char*>(this->bytes), this->length);
+    }
+}
+
+/**
+ * MappedFile::data()
+ *
+ * Gets the bytes of the file.
+ *
+ * @return
+ *      A read-only pointer to the first byte of the file, valid for the lifetime of the MappedFile,
+ *      or nullptr if the file is empty.
+ */
+const unsigned char* MappedFile::data() const {
+    return this->bytes;
+}
+
+/**
+ * MappedFile::size()
+ *
+ * Gets the size of the file.
+ *
+ * @return
+ *      The number of bytes in the file.
+ */
+size_t MappedFile::size() const {
+    return this->length;
+}
@@ -0,0 +1,27 @@
+/**
+ * Declares a class representing a read-only memory mapping of a whole file.
+ * Rich documentation for the api and behaviour the MappedFile class can be found in mapped_file.cpp.
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * Declare the structure of the MappedFile class for reading a file in place, without copying it into a buffer.
+ * The mapping is released when the MappedFile is destroyed.
+ */
+class MappedFile {
+    private:
+        const unsigned char *bytes;
+        size_t length;
+
+    public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile& operator=(const MappedFile &other) = delete;
+
+        const unsigned char* data() const;
+        size_t size() const;
+
+};
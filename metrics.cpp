@@ -0,0 +1,410 @@
+/**
+ * Implements a class which records the timings of a run of the simulation as JSON lines.
+ *      - A record of stepping the world is one line of JSON, with "type": "generation" for a single generation
+ *        stepped, or "type": "generations" for many generations advanced in one call.
+ *      - The last line has "type": "summary", with the generations per second, the p50, p99 and maximum
+ *        mean latency of a generation over each record, and the total time spent in each phase of the run.
+ *        A record of a single generation has its own latency, so these are true per generation latencies
+ *        whenever generations take longer than a group, see Metrics::get_group_size().
+ *      - Lines are formatted into a buffer without any locale or stream formatting, and written out in
+ *        large blocks, so a record costs well under a microsecond.
+ *      - Generations which take less than 40 microseconds are recorded in groups, see Metrics::get_group_size(),
+ *        so recording costs well under 1% of stepping even a small world.
+ */
+#include "metrics.h"
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cmath>
+
+/**
+ * Metrics::Metrics(path)
+ *
+ * Construct a recorder which writes JSON lines to a file, replacing it if it exists.
+ *
+ * @example
+ *
+ *      // Time each generation of a world
+ *      Metrics metrics("path/to/metrics.jsonl");
+ *      for (unsigned long long generation = 1; generation <= 100; generation++) {
+ *          const Metrics::Clock::time_point start = Metrics::Clock::now();
+ *          world.step();
+ *          const Metrics::Clock::time_point end = Metrics::Clock::now();
+ *          metrics.add_generation(generation, start, end, world.get_alive_cells(),
+ *              world.get_births(), world.get_deaths(), world.get_active_tiles());
+ *          metrics.add_phase(Metrics::Phase::STEP, start, end);
+ *      }
+ *      metrics.finish();
+ *
+ * @param path
+ *      The path of the file to write to.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be opened.
+ */
+Metrics::Metrics(const std::string &path)
+    : output(path, std::ios::binary | std::ios::trunc), histogram(61 * Metrics::SUB_BUCKETS, 0), max_latency(0),
+      generations(0), phase_nanoseconds{0, 0, 0, 0, 0}, group_size(1) {
+    if (!this->output.is_open()) {
+        throw std::runtime_error("Metrics() : File cannot be opened.");
+    }
+    this->buffer.reserve(1 << 16);
+}
+
+/**
+ * Metrics::get_nanoseconds(start, end)
+ *
+ * Gets the time between two readings of Metrics::Clock.
+ *
+ * @return
+ *      The nanoseconds from start to end, or 0 if end is not after start.
+ */
+uint64_t Metrics::get_nanoseconds(const Clock::time_point start, const Clock::time_point end) {
+    const long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return nanoseconds > 0 ? (uint64_t)nanoseconds : 0;
+}
+
+/**
+ * Metrics::get_bucket(nanoseconds)
+ *
+ * Gets the bucket of the histogram a latency falls in. Latencies under 16ns have a bucket each, larger ones are
+ * bucketed by their 5 most significant bits, so a bucket is never wider than 1/16th of the latencies in it.
+ *
+ * @return
+ *      The index of the bucket.
+ */
+unsigned int Metrics::get_bucket(const uint64_t nanoseconds) {
+    if (nanoseconds < Metrics::SUB_BUCKETS) {
+        return (unsigned int)nanoseconds;
+    }
+    const unsigned int shift = 63 - __builtin_clzll(nanoseconds) - 4;
+    return (shift + 1) * Metrics::SUB_BUCKETS + (unsigned int)((nanoseconds >> shift) & (Metrics::SUB_BUCKETS - 1));
+}
+
+/**
+ * Metrics::get_bucket_limit(bucket)
+ *
+ * Gets the largest latency which falls in a bucket of the histogram, see Metrics::get_bucket(nanoseconds).
+ *
+ * @return
+ *      The largest latency of the bucket in nanoseconds.
+ */
+uint64_t Metrics::get_bucket_limit(const unsigned int bucket) {
+    if (bucket < Metrics::SUB_BUCKETS) {
+        return bucket;
+    }
+    const unsigned int shift = bucket / Metrics::SUB_BUCKETS - 1;
+    const uint64_t lowest = (uint64_t)(Metrics::SUB_BUCKETS + bucket % Metrics::SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t)1 << shift) - 1;
+}
+
+/**
+ * Metrics::get_percentile(percentile)
+ *
+ * Gets a percentile of the mean latency of a generation over each record from the histogram.
+ *
+ * @param percentile
+ *      The fraction of generations, from 0 to 1, which are at least as fast as the latency returned.
+ *
+ * @return
+ *      The largest latency of the bucket the percentile falls in, capped at the largest latency seen,
+ *      or 0 if no generations were recorded.
+ */
+uint64_t Metrics::get_percentile(const double percentile) const {
+    if (this->generations == 0) {
+        return 0;
+    }
+    const unsigned long long rank = std::max(1ULL, (unsigned long long)std::ceil(percentile * this->generations));
+    unsigned long long seen = 0;
+    for (unsigned int bucket = 0; bucket < this->histogram.size(); bucket++) {
+        seen += this->histogram[bucket];
+        if (seen >= rank) {
+            return std::min(Metrics::get_bucket_limit(bucket), this->max_latency);
+        }
+    }
+    return this->max_latency;
+}
+
+/**
+ * Metrics::add_latency(nanoseconds, count)
+ *
+ * Add a number of generations which each took the same time to the histogram.
+ */
+void Metrics::add_latency(const uint64_t nanoseconds, const unsigned long long count) {
+    this->histogram[Metrics::get_bucket(nanoseconds)] += count;
+    this->max_latency = std::max(this->max_latency, nanoseconds);
+    this->generations += count;
+}
+
+/**
+ * append_field(buffer, name, value)
+ *
+ * Append an integer field of a JSON object to a buffer, formatted with std::to_chars.
+ */
+static void append_field(std::string &buffer, const char *name, const unsigned long long value) {
+    char digits[24];
+    const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer += ",\"";
+    buffer += name;
+    buffer += "\":";
+    buffer.append(digits, result.ptr);
+}
+
+/**
+ * Metrics::write_buffer()
+ *
+ * Write the lines waiting in the buffer to the file.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void Metrics::write_buffer() {
+    this->output.write(this->buffer.data(), (std::streamsize)this->buffer.size());
+    this->buffer.clear();
+    if (!this->output) {
+        throw std::runtime_error("write_buffer() : File cannot be written.");
+    }
+}
+
+/**
+ * Metrics::get_group_size()
+ *
+ * Gets how many generations to advance before the next record, so that recording costs well under 1% of the
+ * time spent stepping however small the world is. It starts at 1 and doubles while the records covering a full
+ * group take under 20 microseconds, and halves while they take over 80 microseconds, so a world whose
+ * generations take 40 microseconds or more, such as most worlds of 300x300 cells, is recorded one generation
+ * at a time.
+ *
+ * @example
+ *
+ *      // Advance a world in groups of generations, recording each group
+ *      for (unsigned long long generation = 0; generation < 1000000; ) {
+ *          const unsigned long long count = std::min(metrics.get_group_size(), 1000000 - generation);
+ *          const Metrics::Clock::time_point start = Metrics::Clock::now();
+ *          world.advance(count);
+ *          const Metrics::Clock::time_point end = Metrics::Clock::now();
+ *          generation += count;
+ *          metrics.add_generations(generation, count, start, end, world.get_alive_cells(),
+ *              world.get_births(), world.get_deaths(), world.get_active_tiles());
+ *      }
+ *
+ * @return
+ *      The number of generations to advance before recording them.
+ */
+unsigned long long Metrics::get_group_size() const {
+    return this->group_size;
+}
+
+/**
+ * Metrics::update_group_size(nanoseconds, count)
+ *
+ * Private helper which resizes the group after a record, see Metrics::get_group_size().
+ * Records cut short of a full group, by printing or checkpointing, never grow it.
+ */
+void Metrics::update_group_size(const uint64_t nanoseconds, const unsigned long long count) {
+    if (nanoseconds < Metrics::GROUP_NANOSECONDS / 2 && count >= this->group_size && this->group_size < (1ULL << 40)) {
+        this->group_size *= 2;
+    }
+    else if (nanoseconds > Metrics::GROUP_NANOSECONDS * 2 && this->group_size > 1) {
+        this->group_size /= 2;
+    }
+}
+
+/**
+ * Metrics::add_phase(phase, start, end)
+ *
+ * Add the time between two readings of Metrics::Clock to the total of a phase of the run.
+ *
+ * @param phase
+ *      The phase of the run the time was spent in.
+ *
+ * @param start
+ *      The time the phase started.
+ *
+ * @param end
+ *      The time the phase ended.
+ */
+void Metrics::add_phase(const Phase phase, const Clock::time_point start, const Clock::time_point end) {
+    this->phase_nanoseconds[(unsigned int)phase] += Metrics::get_nanoseconds(start, end);
+}
+
+/**
+ * Metrics::add_generation(generation, start, end, population, births, deaths, active_tiles)
+ *
+ * Record a single generation stepped, as a line of the form
+ *      {"type":"generation","generation":1,"nanoseconds":1234,"population":5,"births":2,"deaths":2,"active_tiles":4}
+ *
+ * @param generation
+ *      The generation reached by the step.
+ *
+ * @param start
+ *      The time the step started.
+ *
+ * @param end
+ *      The time the step ended.
+ *
+ * @param population
+ *      The number of alive cells after the step.
+ *
+ * @param births
+ *      The number of cells born by the step.
+ *
+ * @param deaths
+ *      The number of cells which died in the step.
+ *
+ * @param active_tiles
+ *      The number of tiles the step evaluated, see World::get_active_tiles().
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void Metrics::add_generation(const unsigned long long generation, const Clock::time_point start,
+    const Clock::time_point end, const unsigned int population, const unsigned int births, const unsigned int deaths,
+    const unsigned int active_tiles) {
+    const uint64_t nanoseconds = Metrics::get_nanoseconds(start, end);
+    this->add_latency(nanoseconds, 1);
+    this->update_group_size(nanoseconds, 1);
+
+    this->buffer += "{\"type\":\"generation\"";
+    append_field(this->buffer, "generation", generation);
+    append_field(this->buffer, "nanoseconds", nanoseconds);
+    append_field(this->buffer, "population", population);
+    append_field(this->buffer, "births", births);
+    append_field(this->buffer, "deaths", deaths);
+    append_field(this->buffer, "active_tiles", active_tiles);
+    this->buffer += "}\n";
+    if (this->buffer.size() >= (1 << 16)) {
+        this->write_buffer();
+    }
+}
+
+/**
+ * Metrics::add_record(generation, count, nanoseconds, population, counted, births, deaths, active_tiles)
+ *
+ * Private helper which records many generations advanced in one call, with their births and deaths if they were
+ * counted, see Metrics::add_generations(generation, count, start, end, population, births, deaths, active_tiles).
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void Metrics::add_record(const unsigned long long generation, const unsigned long long count,
+    const uint64_t nanoseconds, const unsigned int population, const bool counted, const unsigned int births,
+    const unsigned int deaths, const unsigned int active_tiles) {
+    if (count == 0) {
+        return;
+    }
+    this->add_latency(nanoseconds / count, count);
+    this->update_group_size(nanoseconds, count);
+
+    this->buffer += "{\"type\":\"generations\"";
+    append_field(this->buffer, "generation", generation);
+    append_field(this->buffer, "count", count);
+    append_field(this->buffer, "nanoseconds", nanoseconds);
+    append_field(this->buffer, "population", population);
+    if (counted) {
+        append_field(this->buffer, "births", births);
+        append_field(this->buffer, "deaths", deaths);
+    }
+    append_field(this->buffer, "active_tiles", active_tiles);
+    this->buffer += "}\n";
+    if (this->buffer.size() >= (1 << 16)) {
+        this->write_buffer();
+    }
+}
+
+/**
+ * Metrics::add_generations(generation, count, start, end, population, births, deaths, active_tiles)
+ *
+ * Record many generations advanced in one call, as a line of the form
+ *      {"type":"generations","generation":1000,"count":1000,"nanoseconds":123456,"population":5,"births":812,
+ *       "deaths":810,"active_tiles":4}
+ *
+ * The generations in between are not timed one by one, so each counts towards the latency histogram as taking
+ * the mean time of the call.
+ *
+ * @param generation
+ *      The generation reached by the call.
+ *
+ * @param count
+ *      The number of generations advanced.
+ *
+ * @param start
+ *      The time the call started.
+ *
+ * @param end
+ *      The time the call ended.
+ *
+ * @param population
+ *      The number of alive cells after the call.
+ *
+ * @param births
+ *      The number of cells born over the call, see World::get_births().
+ *
+ * @param deaths
+ *      The number of cells which died over the call, see World::get_deaths().
+ *
+ * @param active_tiles
+ *      The number of tiles the last generation of the call evaluated, see World::get_active_tiles().
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void Metrics::add_generations(const unsigned long long generation, const unsigned long long count,
+    const Clock::time_point start, const Clock::time_point end, const unsigned int population,
+    const unsigned int births, const unsigned int deaths, const unsigned int active_tiles) {
+    this->add_record(generation, count, Metrics::get_nanoseconds(start, end), population, true, births, deaths,
+        active_tiles);
+}
+
+/**
+ * Metrics::add_generations(generation, count, start, end, population, active_tiles)
+ *
+ * Record many generations advanced in one call by an engine which does not count births and deaths, such as
+ * World::Engine::BITS or World::Engine::HASHLIFE, as a line of the form
+ *      {"type":"generations","generation":1000,"count":1000,"nanoseconds":123456,"population":5,"active_tiles":4}
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void Metrics::add_generations(const unsigned long long generation, const unsigned long long count,
+    const Clock::time_point start, const Clock::time_point end, const unsigned int population,
+    const unsigned int active_tiles) {
+    this->add_record(generation, count, Metrics::get_nanoseconds(start, end), population, false, 0, 0, active_tiles);
+}
+
+/**
+ * Metrics::finish()
+ *
+ * Write the summary of the run as the last line, of the form
+ *      {"type":"summary","generations":100,"generations_per_second":1.2e+06,
+ *       "mean_latency_nanoseconds":{"p50":800,"p99":1500,"max":9000},
+ *       "phase_seconds":{"load":0.01,"step":0.08,"render":0,"checkpoint":0,"save":0.02}}
+ * and flush the file. The generations per second are over the time spent in Metrics::Phase::STEP. The latencies are
+ * of the mean generation of each record weighted by its generations, so a slow generation within a group only
+ * raises the mean of its group, and the max is the slowest record rather than the slowest generation.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be written.
+ */
+void Metrics::finish() {
+    const double step_seconds = this->phase_nanoseconds[(unsigned int)Phase::STEP] * 1e-9;
+    char line[512];
+    std::snprintf(line, sizeof(line),
+        "{\"type\":\"summary\",\"generations\":%llu,\"generations_per_second\":%.6g,"
+        "\"mean_latency_nanoseconds\":{\"p50\":%llu,\"p99\":%llu,\"max\":%llu},"
+        "\"phase_seconds\":{\"load\":%.6g,\"step\":%.6g,\"render\":%.6g,\"checkpoint\":%.6g,\"save\":%.6g}}\n",
+        this->generations, step_seconds > 0 ? this->generations / step_seconds : 0.0,
+        (unsigned long long)this->get_percentile(0.5), (unsigned long long)this->get_percentile(0.99),
+        (unsigned long long)this->max_latency,
+        this->phase_nanoseconds[(unsigned int)Phase::LOAD] * 1e-9, step_seconds,
+        this->phase_nanoseconds[(unsigned int)Phase::RENDER] * 1e-9,
+        this->phase_nanoseconds[(unsigned int)Phase::CHECKPOINT] * 1e-9,
+        this->phase_nanoseconds[(unsigned int)Phase::SAVE] * 1e-9);
+    this->buffer += line;
+    this->write_buffer();
+    this->output.flush();
+    if (!this->output) {
+        throw std::runtime_error("finish() : File cannot be written.");
+    }
+}
@@ -0,0 +1,228 @@
+/**
+ * Implements a class which reads the hardware performance counters of the process, using perf_event_open on Linux.
+ *      - The counters follow the thread which opened them and every thread it starts afterwards, so a World
+ *        should be given its threads after the counters are opened for the work of its ThreadPool to be counted.
+ *      - Only user space is counted, which is all that the simulation runs in, and which perf_event_paranoid
+ *        allows unprivileged processes to count on most systems.
+ *      - When the kernel has to share the hardware between more events than it has counters, the counts are
+ *        scaled up by the fraction of the time each event was actually counted.
+ *      - On other systems, in virtual machines without a PMU, or when perf_event_paranoid forbids it,
+ *        the events are unavailable and count 0.
+ */
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+/**
+ * open_event(type, config)
+ *
+ * Open a counter of one event for this thread and the threads it starts from now on, stopped at 0.
+ *
+ * @return
+ *      The file descriptor of the counter, or -1 if it cannot be opened.
+ */
+static int open_event(const uint32_t type, const uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/**
+ * PerfCounters::PerfCounters()
+ *
+ * Construct a set of counters of every PerfCounters::Event, stopped at 0.
+ * An event which cannot be counted is unavailable rather than an error, see PerfCounters::is_available(event).
+ *
+ * @example
+ *
+ *      // Count the events of stepping a world, including its threads
+ *      PerfCounters counters;
+ *      World world(grid);
+ *      world.set_threads(4);
+ *      counters.start();
+ *      world.advance(1000);
+ *      counters.stop();
+ *
+ *      // Print the instructions per cycle
+ *      if (counters.is_available(PerfCounters::Event::CYCLES) && counters.is_available(PerfCounters::Event::INSTRUCTIONS)) {
+ *          std::cout << (double)counters.get_count(PerfCounters::Event::INSTRUCTIONS) /
+ *                       counters.get_count(PerfCounters::Event::CYCLES) << std::endl;
+ *      }
+ */
+PerfCounters::PerfCounters() {
+    for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+        this->descriptors[i] = -1;
+    }
+#ifdef __linux__
+    const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    this->descriptors[(unsigned int)Event::CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    this->descriptors[(unsigned int)Event::INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    this->descriptors[(unsigned int)Event::L1D_MISSES] = open_event(PERF_TYPE_HW_CACHE, l1d_read_miss);
+    this->descriptors[(unsigned int)Event::LLC_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    this->descriptors[(unsigned int)Event::BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+}
+
+/**
+ * PerfCounters::~PerfCounters()
+ *
+ * Close the counters.
+ */
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+        if (this->descriptors[i] >= 0) {
+            close(this->descriptors[i]);
+        }
+    }
+#endif
+}
+
+/**
+ * PerfCounters::is_available()
+ *
+ * Checks if any event can be counted.
+ *
+ * @return
+ *      True if at least one event is available.
+ */
+bool PerfCounters::is_available() const {
+    for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+        if (this->descriptors[i] >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * PerfCounters::is_available(event)
+ *
+ * Checks if an event can be counted.
+ *
+ * @param event
+ *      The event to check.
+ *
+ * @return
+ *      True if the event is counted, false if it always counts 0.
+ */
+bool PerfCounters::is_available(const Event event) const {
+    return this->descriptors[(unsigned int)event] >= 0;
+}
+
+/**
+ * PerfCounters::start()
+ *
+ * Start counting, adding to the counts so far.
+ */
+void PerfCounters::start() {
+#ifdef __linux__
+    for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+        if (this->descriptors[i] >= 0) {
+            ioctl(this->descriptors[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+/**
+ * PerfCounters::stop()
+ *
+ * Stop counting, keeping the counts so far.
+ */
+void PerfCounters::stop() {
+#ifdef __linux__
+    for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+        if (this->descriptors[i] >= 0) {
+            ioctl(this->descriptors[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+}
+
+/**
+ * PerfCounters::reset()
+ *
+ * Set every count back to 0.
+ */
+void PerfCounters::reset() {
+#ifdef __linux__
+    for (unsigned int i = 0; i < PerfCounters::EVENTS; i++) {
+        if (this->descriptors[i] >= 0) {
+            ioctl(this->descriptors[i], PERF_EVENT_IOC_RESET, 0);
+        }
+    }
+#endif
+}
+
+/**
+ * PerfCounters::get_count(event)
+ *
+ * Gets the number of times an event happened while the counters were started, since they were opened or reset.
+ *
+ * @param event
+ *      The event to get the count of.
+ *
+ * @return
+ *      The count, scaled up if the event was only counted for part of the time, or 0 if it is unavailable.
+ */
+uint64_t PerfCounters::get_count(const Event event) const {
+#ifdef __linux__
+    const int descriptor = this->descriptors[(unsigned int)event];
+    if (descriptor < 0) {
+        return 0;
+    }
+    // The count, then the time enabled and the time running, see PERF_FORMAT_TOTAL_TIME_ENABLED
+    uint64_t values[3] = {0, 0, 0};
+    if (read(descriptor, values, sizeof(values)) != (ssize_t)sizeof(values) || values[2] == 0) {
+        return 0;
+    }
+    if (values[2] < values[1]) {
+        return (uint64_t)((double)values[0] * values[1] / values[2]);
+    }
+    return values[0];
+#else
+    (void)event;
+    return 0;
+#endif
+}
+
+/**
+ * PerfCounters::get_name(event)
+ *
+ * Gets the name of an event, as used in reports.
+ *
+ * @return
+ *      The name of the event in snake case, e.g. "branch_misses".
+ */
+std::string PerfCounters::get_name(const Event event) {
+    switch (event) {
+        case Event::CYCLES:
+            return "cycles";
+        case Event::INSTRUCTIONS:
+            return "instructions";
+        case Event::L1D_MISSES:
+            return "l1d_misses";
+        case Event::LLC_MISSES:
+            return "llc_misses";
+        default:
+            return "branch_misses";
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * Declares a class which reads the hardware performance counters of the process.
+ * Rich documentation for the api and behaviour the PerfCounters class can be found in perf_counters.cpp.
+ */
+#pragma once
+#include <string>
+#include <cstdint>
+
+/**
+ * Declare the structure of the PerfCounters class for counting hardware events around a piece of code.
+ *
+ * Each event is opened separately, so an event the machine cannot count is reported as unavailable
+ * without losing the others, and a machine with no counters at all costs nothing but the failed opens.
+ */
+class PerfCounters {
+    public:
+        /**
+         * The hardware events counted.
+         *      - CYCLES, the CPU cycles spent.
+         *      - INSTRUCTIONS, the instructions retired.
+         *      - L1D_MISSES, the loads which missed the level 1 data cache.
+         *      - LLC_MISSES, the accesses which missed the last level cache and went to memory.
+         *      - BRANCH_MISSES, the branches which were mispredicted.
+         */
+        enum class Event {
+            CYCLES,
+            INSTRUCTIONS,
+            L1D_MISSES,
+            LLC_MISSES,
+            BRANCH_MISSES
+        };
+
+        static const unsigned int EVENTS = 5;
+
+    private:
+        int descriptors[EVENTS];
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters &other) = delete;
+        PerfCounters& operator=(const PerfCounters &other) = delete;
+
+        bool is_available() const;
+        bool is_available(const Event event) const;
+        void start();
+        void stop();
+        void reset();
+        uint64_t get_count(const Event event) const;
+
+        static std::string get_name(const Event event);
+
+};
@@ -0,0 +1,205 @@
+/**
+ * Implements a class representing an outer-totalistic Life-like rule in B/S notation.
+ *      - A rule is two sets of neighbour counts: the counts on which a dead cell is born,
+ *        and the counts on which an alive cell survives. Every other cell is dead in the next generation.
+ *      - Rules are parsed from and printed as B/S notation, e.g. B3/S23 for Conway's Game of Life.
+ *      - Each set is stored as a bitmask, bit n is set if the count n is in the set.
+ *
+ * Kernels which should not pay for interpreting the rule are specialized on a StaticRule instead,
+ * see rule.h for the rules which have specializations.
+ *
+ * Rules: https://www.conwaylife.com/wiki/Rulestring
+ */
+#include "rule.h"
+#include <cctype>
+#include <stdexcept>
+
+/**
+ * Rule::Rule()
+ *
+ * Construct the rule of Conway's Game of Life, B3/S23.
+ *
+ * @example
+ *
+ *      // Make the default rule
+ *      Rule rule;
+ */
+Rule::Rule() : Rule(ConwayRule()) {
+}
+
+/**
+ * Rule::Rule(birth, survival)
+ *
+ * Construct a rule from its two bitmasks.
+ *
+ * @example
+ *
+ *      // Make HighLife, B36/S23
+ *      Rule rule(1 << 3 | 1 << 6, 1 << 2 | 1 << 3);
+ *
+ * @param birth
+ *      Bit n is set if a dead cell with n alive neighbours becomes alive.
+ *
+ * @param survival
+ *      Bit n is set if an alive cell with n alive neighbours stays alive.
+ *
+ * @throws
+ *      std::invalid_argument if a bit above bit 8 is set, a cell has at most 8 neighbours.
+ */
+Rule::Rule(const uint16_t birth, const uint16_t survival) : birth(birth), survival(survival) {
+    if ((birth | survival) >> 9) {
+        throw std::invalid_argument("Rule() : A cell has at most 8 neighbours.");
+    }
+}
+
+/**
+ * Rule::Rule(notation)
+ *
+ * Parse a rule from B/S notation, the birth counts after a B and the survival counts after an S,
+ * separated by a / (slash). The letters are case insensitive and the two halves may come in either order.
+ * The names conway, highlife, daynight and seeds are accepted as well.
+ *
+ * @example
+ *
+ *      // Make HighLife
+ *      Rule highlife("B36/S23");
+ *
+ *      // Make Seeds, where no cell survives
+ *      Rule seeds("B2/S");
+ *
+ * @param notation
+ *      The rule in B/S notation.
+ *
+ * @throws
+ *      std::invalid_argument if the notation cannot be parsed.
+ */
+Rule::Rule(const std::string &notation) : birth(0), survival(0) {
+    std::string lower;
+    for (const char c : notation) {
+        lower += (char)std::tolower((unsigned char)c);
+    }
+    if (lower == "conway" || lower == "life") {
+        *this = Rule(ConwayRule());
+        return;
+    }
+    if (lower == "highlife") {
+        *this = Rule(HighLifeRule());
+        return;
+    }
+    if (lower == "daynight") {
+        *this = Rule(DayAndNightRule());
+        return;
+    }
+    if (lower == "seeds") {
+        *this = Rule(SeedsRule());
+        return;
+    }
+
+    const size_t slash = lower.find('/');
+    if (slash == std::string::npos) {
+        throw std::invalid_argument("Rule() : Missing / between the birth and survival counts.");
+    }
+    bool seen_birth = false;
+    bool seen_survival = false;
+    for (const std::string &half : {lower.substr(0, slash), lower.substr(slash + 1)}) {
+        if (half.empty() || (half[0] != 'b' && half[0] != 's')) {
+            throw std::invalid_argument("Rule() : Each half must start with B or S.");
+        }
+        bool &seen = half[0] == 'b' ? seen_birth : seen_survival;
+        uint16_t &mask = half[0] == 'b' ? this->birth : this->survival;
+        if (seen) {
+            throw std::invalid_argument("Rule() : B or S appears twice.");
+        }
+        seen = true;
+        for (size_t i = 1; i < half.size(); i++) {
+            if (half[i] < '0' || half[i] > '8') {
+                throw std::invalid_argument("Rule() : Neighbour counts must be digits from 0 to 8.");
+            }
+            mask |= 1 << (half[i] - '0');
+        }
+    }
+}
+
+/**
+ * Rule::get_birth()
+ *
+ * Gets the birth counts of the rule.
+ *
+ * @return
+ *      A bitmask where bit n is set if a dead cell with n alive neighbours becomes alive.
+ */
+uint16_t Rule::get_birth() const {
+    return this->birth;
+}
+
+/**
+ * Rule::get_survival()
+ *
+ * Gets the survival counts of the rule.
+ *
+ * @return
+ *      A bitmask where bit n is set if an alive cell with n alive neighbours stays alive.
+ */
+uint16_t Rule::get_survival() const {
+    return this->survival;
+}
+
+/**
+ * Rule::next(alive, neighbours)
+ *
+ * Apply the rule to a single cell.
+ *
+ * @example
+ *
+ *      // A dead cell with 3 neighbours is born under Conway's rules
+ *      bool alive = Rule().next(false, 3);
+ *
+ * @param alive
+ *      If the cell is alive now.
+ *
+ * @param neighbours
+ *      The number of alive neighbours of the cell, from 0 to 8.
+ *
+ * @return
+ *      If the cell is alive in the next generation.
+ */
+bool Rule::next(const bool alive, const unsigned int neighbours) const {
+    return ((alive ? this->survival : this->birth) >> neighbours) & 1;
+}
+
+/**
+ * Rule::to_string()
+ *
+ * Print the rule in B/S notation, with the counts in increasing order.
+ *
+ * @example
+ *
+ *      // Prints B3/S23
+ *      std::cout << Rule().to_string() << std::endl;
+ *
+ * @return
+ *      The rule in B/S notation.
+ */
+std::string Rule::to_string() const {
+    std::string notation = "B";
+    for (unsigned int n = 0; n <= 8; n++) {
+        if ((this->birth >> n) & 1) {
+            notation += (char)('0' + n);
+        }
+    }
+    notation += "/S";
+    for (unsigned int n = 0; n <= 8; n++) {
+        if ((this->survival >> n) & 1) {
+            notation += (char)('0' + n);
+        }
+    }
+    return notation;
+}
+
+bool Rule::operator==(const Rule &other) const {
+    return this->birth == other.birth && this->survival == other.survival;
+}
+
+bool Rule::operator!=(const Rule &other) const {
+    return !(*this == other);
+}
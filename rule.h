@@ -0,0 +1,50 @@
+/**
+ * Declares a class representing an outer-totalistic Life-like rule in B/S notation.
+ * Rich documentation for the api and behaviour the Rule class can be found in rule.cpp.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+/**
+ * A rule fixed at compile time, for kernels which are specialized on the rule.
+ * Bit n of BIRTH is set if a dead cell with n alive neighbours becomes alive,
+ * bit n of SURVIVAL is set if an alive cell with n alive neighbours stays alive.
+ */
+template <uint16_t BIRTH, uint16_t SURVIVAL>
+struct StaticRule {
+    static constexpr uint16_t birth = BIRTH;
+    static constexpr uint16_t survival = SURVIVAL;
+};
+
+// The rules with specialized kernels.
+typedef StaticRule<1 << 3, 1 << 2 | 1 << 3> ConwayRule;                                          // B3/S23
+typedef StaticRule<1 << 3 | 1 << 6, 1 << 2 | 1 << 3> HighLifeRule;                               // B36/S23
+typedef StaticRule<1 << 3 | 1 << 6 | 1 << 7 | 1 << 8,
+                   1 << 3 | 1 << 4 | 1 << 6 | 1 << 7 | 1 << 8> DayAndNightRule;                  // B3678/S34678
+typedef StaticRule<1 << 2, 0> SeedsRule;                                                         // B2/S
+
+/**
+ * Declare the structure of the Rule class for representing a Life-like rule chosen at run time.
+ */
+class Rule {
+    private:
+        uint16_t birth;
+        uint16_t survival;
+
+    public:
+        Rule();
+        Rule(const uint16_t birth, const uint16_t survival);
+        explicit Rule(const std::string &notation);
+
+        template <uint16_t BIRTH, uint16_t SURVIVAL>
+        Rule(const StaticRule<BIRTH, SURVIVAL>) : birth(BIRTH), survival(SURVIVAL) {}
+
+        uint16_t get_birth() const;
+        uint16_t get_survival() const;
+        bool next(const bool alive, const unsigned int neighbours) const;
+        std::string to_string() const;
+        bool operator==(const Rule &other) const;
+        bool operator!=(const Rule &other) const;
+
+};
@@ -0,0 +1,479 @@
+/**
+ * Implements a class representing up to 256 small worlds of the same size, bit-sliced so they step in lockstep.
+ *      - New worlds are filled with dead cells.
+ *      - Worlds are packed in from and unpacked out to Grid objects, one at a time or all at once.
+ *      - Every initial state of a world of up to 64 cells can be enumerated, SlicedWorlds::CAPACITY at a time.
+ *      - All worlds step in lockstep under one Life-like rule, on a bounded plane or a torus.
+ *
+ * Bit-slicing turns the per-world overhead of tiny worlds into nothing: stepping a 4x4 world one cell per word
+ * would waste 60 of every 64 bits, whereas here every bit of every word is a cell of some world.
+ */
+#include "sliced_worlds.h"
+#include "bitlogic.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+// A lane of LANE_WORDS words in one register, a GCC vector extension type with AVX2, otherwise a plain word.
+#if defined(__AVX2__)
+typedef uint64_t Lane __attribute__((vector_size(32)));
+#else
+typedef uint64_t Lane;
+#endif
+
+/**
+ * SlicedWorlds::SlicedWorlds()
+ *
+ * Construct worlds of size 0x0.
+ *
+ * @example
+ *
+ *      // Make 0x0 worlds
+ *      SlicedWorlds worlds;
+ *
+ */
+SlicedWorlds::SlicedWorlds() : SlicedWorlds(0) {
+}
+
+/**
+ * SlicedWorlds::SlicedWorlds(square_size)
+ *
+ * Construct SlicedWorlds::CAPACITY square worlds filled with dead cells.
+ *
+ * @example
+ *
+ *      // Make 4x4 worlds
+ *      SlicedWorlds worlds(4);
+ *
+ * @param square_size
+ *      The edge size to use for the width and height of every world.
+ */
+SlicedWorlds::SlicedWorlds(const unsigned int square_size) : SlicedWorlds(square_size, square_size) {
+}
+
+/**
+ * SlicedWorlds::SlicedWorlds(width, height)
+ *
+ * Construct SlicedWorlds::CAPACITY worlds filled with dead cells, stepped with Conway's Game of Life until changed.
+ *
+ * @example
+ *
+ *      // Make 8x4 worlds
+ *      SlicedWorlds worlds(8, 4);
+ *
+ * @param width
+ *      The width of every world.
+ *
+ * @param height
+ *      The height of every world.
+ */
+SlicedWorlds::SlicedWorlds(const unsigned int width, const unsigned int height)
+    : width(width), height(height),
+      curr((size_t)(width + 2) * (height + 2) * LANE_WORDS, 0),
+      next((size_t)(width + 2) * (height + 2) * LANE_WORDS, 0) {
+}
+
+/**
+ * SlicedWorlds::get_width()
+ *
+ * Gets the width of every world.
+ *
+ * @return
+ *      The width in cells.
+ */
+unsigned int SlicedWorlds::get_width() const {
+    return this->width;
+}
+
+/**
+ * SlicedWorlds::get_height()
+ *
+ * Gets the height of every world.
+ *
+ * @return
+ *      The height in cells.
+ */
+unsigned int SlicedWorlds::get_height() const {
+    return this->height;
+}
+
+/**
+ * SlicedWorlds::get_state(index)
+ *
+ * Gets the current state of one world, unpacked into a Grid.
+ *
+ * @example
+ *
+ *      // Print the last world
+ *      std::cout << worlds.get_state(SlicedWorlds::CAPACITY - 1) << std::endl;
+ *
+ * @param index
+ *      The index of the world, less than SlicedWorlds::CAPACITY.
+ *
+ * @return
+ *      A grid of the size of the worlds.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not less than SlicedWorlds::CAPACITY.
+ */
+Grid SlicedWorlds::get_state(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("get_state() : Invalid index.");
+    }
+    Grid grid(this->width, this->height);
+    for (unsigned int y = 0; y < this->height; y++) {
+        Cell *cells = grid.row(y);
+        for (unsigned int x = 0; x < this->width; x++) {
+            if ((this->lane(this->curr, x, y)[index / 64] >> (index % 64)) & 1) {
+                cells[x] = Cell::ALIVE;
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * SlicedWorlds::set_state(index, grid)
+ *
+ * Replace the state of one world, leaving the others as they are.
+ *
+ * @example
+ *
+ *      // Put a glider in the first world
+ *      SlicedWorlds worlds(8);
+ *      Grid grid(8);
+ *      grid.merge(Zoo::glider(), 0, 0);
+ *      worlds.set_state(0, grid);
+ *
+ * @param index
+ *      The index of the world, less than SlicedWorlds::CAPACITY.
+ *
+ * @param grid
+ *      The new state, which must be the size of the worlds.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not less than SlicedWorlds::CAPACITY or the grid is the wrong size.
+ */
+void SlicedWorlds::set_state(const unsigned int index, const Grid &grid) {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("set_state() : Invalid index.");
+    }
+    if (grid.get_width() != this->width || grid.get_height() != this->height) {
+        throw std::invalid_argument("set_state() : Grid is not the size of the worlds.");
+    }
+    const uint64_t bit = (uint64_t)1 << (index % 64);
+    for (unsigned int y = 0; y < this->height; y++) {
+        const Cell *cells = grid.row(y);
+        for (unsigned int x = 0; x < this->width; x++) {
+            uint64_t &word = this->lane(this->curr, x, y)[index / 64];
+            word = (cells[x] == Cell::ALIVE) ? (word | bit) : (word & ~bit);
+        }
+    }
+}
+
+/**
+ * SlicedWorlds::pack(grids)
+ *
+ * Replace the state of every world, world k with grid k, and the worlds past the last grid with dead cells.
+ *
+ * @example
+ *
+ *      // Step every rotation of an R-pentomino at once
+ *      std::vector<Grid> grids;
+ *      for (int rotation = 0; rotation < 4; rotation++) {
+ *          Grid grid(16);
+ *          grid.merge(Zoo::r_pentomino().rotate(rotation), 6, 6);
+ *          grids.push_back(grid);
+ *      }
+ *      SlicedWorlds worlds(16);
+ *      worlds.pack(grids);
+ *      worlds.advance(10);
+ *      std::vector<Grid> results = worlds.unpack(4);
+ *
+ * @param grids
+ *      The new states, at most SlicedWorlds::CAPACITY of them, each the size of the worlds.
+ *
+ * @throws
+ *      std::invalid_argument if there are too many grids or a grid is the wrong size.
+ */
+void SlicedWorlds::pack(const std::vector<Grid> &grids) {
+    if (grids.size() > CAPACITY) {
+        throw std::invalid_argument("pack() : Too many grids.");
+    }
+    for (const Grid &grid : grids) {
+        if (grid.get_width() != this->width || grid.get_height() != this->height) {
+            throw std::invalid_argument("pack() : Grid is not the size of the worlds.");
+        }
+    }
+    for (unsigned int y = 0; y < this->height; y++) {
+        for (unsigned int x = 0; x < this->width; x++) {
+            uint64_t *cell = this->lane(this->curr, x, y);
+            std::fill(cell, cell + LANE_WORDS, 0);
+            for (unsigned int k = 0; k < grids.size(); k++) {
+                cell[k / 64] |= (uint64_t)(grids[k].row(y)[x] == Cell::ALIVE) << (k % 64);
+            }
+        }
+    }
+}
+
+/**
+ * SlicedWorlds::unpack(count)
+ *
+ * Gets the current state of the first worlds, unpacked into Grid objects.
+ *
+ * @param count
+ *      Optional parameter. The number of worlds to unpack, defaults to SlicedWorlds::CAPACITY.
+ *
+ * @return
+ *      The grids of worlds 0 to count - 1.
+ *
+ * @throws
+ *      std::invalid_argument if count is more than SlicedWorlds::CAPACITY.
+ */
+std::vector<Grid> SlicedWorlds::unpack(const unsigned int count) const {
+    if (count > CAPACITY) {
+        throw std::invalid_argument("unpack() : Too many grids.");
+    }
+    std::vector<Grid> grids(count, Grid(this->width, this->height));
+    for (unsigned int y = 0; y < this->height; y++) {
+        for (unsigned int x = 0; x < this->width; x++) {
+            const uint64_t *cell = this->lane(this->curr, x, y);
+            for (unsigned int k = 0; k < count; k++) {
+                if ((cell[k / 64] >> (k % 64)) & 1) {
+                    grids[k].row(y)[x] = Cell::ALIVE;
+                }
+            }
+        }
+    }
+    return grids;
+}
+
+/**
+ * SlicedWorlds::enumerate(first)
+ *
+ * Replace the state of every world with a numbered initial state: world k gets state first + k, where bit i of the
+ * number is the cell at x = i % width, y = i / width. Calling this with first = 0, CAPACITY, 2 * CAPACITY, ...
+ * steps every initial state of worlds of up to 64 cells, CAPACITY at a time.
+ *
+ * @example
+ *
+ *      // Count the 4x4 seeds which are still alive after 100 generations
+ *      SlicedWorlds worlds(4);
+ *      unsigned int alive = 0;
+ *      for (unsigned long long first = 0; first < 65536; first += SlicedWorlds::CAPACITY) {
+ *          worlds.enumerate(first);
+ *          worlds.advance(100);
+ *          for (unsigned int k = 0; k < SlicedWorlds::CAPACITY; k++) {
+ *              alive += worlds.get_alive_cells(k) > 0;
+ *          }
+ *      }
+ *
+ * @param first
+ *      The number of the state of world 0.
+ *
+ * @throws
+ *      std::invalid_argument if the worlds have more than 64 cells.
+ */
+void SlicedWorlds::enumerate(const unsigned long long first) {
+    const unsigned int cells = this->width * this->height;
+    if (cells > 64) {
+        throw std::invalid_argument("enumerate() : Worlds have more than 64 cells.");
+    }
+    for (unsigned int i = 0; i < cells; i++) {
+        uint64_t *cell = this->lane(this->curr, i % this->width, i / this->width);
+        std::fill(cell, cell + LANE_WORDS, 0);
+        for (unsigned int k = 0; k < CAPACITY; k++) {
+            cell[k / 64] |= (uint64_t)(((first + k) >> i) & 1) << (k % 64);
+        }
+    }
+}
+
+/**
+ * SlicedWorlds::get_rule()
+ *
+ * Gets the Life-like rule every world is stepped with.
+ *
+ * @return
+ *      The rule, B3/S23 unless changed with SlicedWorlds::set_rule(rule).
+ */
+Rule SlicedWorlds::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * SlicedWorlds::set_rule(rule)
+ *
+ * Selects the Life-like rule every world is stepped with.
+ *
+ * @param rule
+ *      The rule to step with.
+ */
+void SlicedWorlds::set_rule(const Rule &rule) {
+    this->rule = rule;
+}
+
+/**
+ * SlicedWorlds::refresh_border(toroidal)
+ *
+ * Private helper which fills the one cell border around the current state: dead cells for bounded worlds,
+ * or a copy of the opposite edge, corners included, for toroidal ones.
+ */
+void SlicedWorlds::refresh_border(const bool torodial) {
+    const unsigned int stride = (this->width + 2) * LANE_WORDS;
+    uint64_t *lanes = this->curr.data();
+    uint64_t *top = lanes;
+    uint64_t *bottom = lanes + (size_t)(this->height + 1) * stride;
+    if (!torodial) {
+        std::fill(top, top + stride, 0);
+        std::fill(bottom, bottom + stride, 0);
+        for (unsigned int y = 1; y <= this->height; y++) {
+            std::fill(lanes + (size_t)y * stride, lanes + (size_t)y * stride + LANE_WORDS, 0);
+            std::fill(lanes + (size_t)y * stride + (this->width + 1) * LANE_WORDS,
+                      lanes + (size_t)(y + 1) * stride, 0);
+        }
+        return;
+    }
+    for (unsigned int y = 1; y <= this->height; y++) {
+        uint64_t *row = lanes + (size_t)y * stride;
+        std::copy(row + this->width * LANE_WORDS, row + (this->width + 1) * LANE_WORDS, row);
+        std::copy(row + LANE_WORDS, row + 2 * LANE_WORDS, row + (this->width + 1) * LANE_WORDS);
+    }
+    std::copy(lanes + (size_t)this->height * stride, lanes + (size_t)(this->height + 1) * stride, top);
+    std::copy(lanes + stride, lanes + 2 * (size_t)stride, bottom);
+}
+
+/**
+ * load_lane(words)
+ *
+ * Load the LANE_WORDS words of a lane into a register.
+ */
+static inline Lane load_lane(const uint64_t *words) {
+    Lane lane;
+    std::memcpy(&lane, words, sizeof(lane));
+    return lane;
+}
+
+/**
+ * step_lanes<CONWAY>(above, row, below, out, width, birth, survival)
+ *
+ * Step one row of cells of every world. The three lanes of each row are carried along the row in registers,
+ * so each cell loads only the three lanes to its east.
+ */
+template <bool CONWAY>
+static inline void step_lanes(const uint64_t *above, const uint64_t *row, const uint64_t *below, uint64_t *out,
+    const unsigned int width, const uint16_t birth, const uint16_t survival) {
+    const unsigned int L = SlicedWorlds::LANE_WORDS;
+    Lane west[3] = {load_lane(above), load_lane(row), load_lane(below)};
+    Lane centre[3] = {load_lane(above + L), load_lane(row + L), load_lane(below + L)};
+    for (unsigned int x = 1; x <= width; x++) {
+        const unsigned int i = (x + 1) * L;
+        const Lane east[3] = {load_lane(above + i), load_lane(row + i), load_lane(below + i)};
+        const BitLogic::CountsOf<Lane> counts = BitLogic::count_neighbours(west[0], centre[0], east[0],
+            west[1], east[1], west[2], centre[2], east[2]);
+        const Lane next = CONWAY ? BitLogic::conway(counts, centre[1])
+                                 : BitLogic::apply(counts, centre[1], birth, survival);
+        std::memcpy(out + x * L, &next, sizeof(next));
+        for (unsigned int r = 0; r < 3; r++) {
+            west[r] = centre[r];
+            centre[r] = east[r];
+        }
+    }
+}
+
+/**
+ * SlicedWorlds::step(toroidal)
+ *
+ * Take one step of every world at once. Every cell costs one pass of the full adder tree of bitlogic.h over the
+ * lanes of its neighbours, however many of the worlds are in use.
+ *
+ * @example
+ *
+ *      // Step every world once on a torus
+ *      worlds.step(true);
+ *
+ * @param toroidal
+ *      Optional parameter. If true then every world is a torus, where the left edge wraps to the right edge
+ *      and the top to the bottom. Defaults to false.
+ */
+void SlicedWorlds::step(const bool torodial) {
+    if (this->width == 0 || this->height == 0) {
+        return;
+    }
+    this->refresh_border(torodial);
+    const unsigned int stride = (this->width + 2) * LANE_WORDS;
+    const bool conway = this->rule == Rule(ConwayRule());
+    const uint16_t birth = this->rule.get_birth();
+    const uint16_t survival = this->rule.get_survival();
+    for (unsigned int y = 1; y <= this->height; y++) {
+        const uint64_t *row = this->curr.data() + (size_t)y * stride;
+        uint64_t *out = this->next.data() + (size_t)y * stride;
+        if (conway) {
+            step_lanes<true>(row - stride, row, row + stride, out, this->width, birth, survival);
+        }
+        else {
+            step_lanes<false>(row - stride, row, row + stride, out, this->width, birth, survival);
+        }
+    }
+    std::swap(this->curr, this->next);
+}
+
+/**
+ * SlicedWorlds::advance(steps, toroidal)
+ *
+ * Take a number of steps of every world at once, see SlicedWorlds::step(toroidal).
+ *
+ * @param steps
+ *      The number of steps to take.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then every world is a torus. Defaults to false.
+ */
+void SlicedWorlds::advance(const unsigned long long steps, const bool torodial) {
+    for (unsigned long long i = 0; i < steps; i++) {
+        this->step(torodial);
+    }
+}
+
+/**
+ * SlicedWorlds::get_alive_cells(index)
+ *
+ * Gets the number of alive cells of one world.
+ *
+ * @param index
+ *      The index of the world, less than SlicedWorlds::CAPACITY.
+ *
+ * @return
+ *      The number of alive cells.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not less than SlicedWorlds::CAPACITY.
+ */
+unsigned int SlicedWorlds::get_alive_cells(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("get_alive_cells() : Invalid index.");
+    }
+    unsigned int alive = 0;
+    for (unsigned int y = 0; y < this->height; y++) {
+        for (unsigned int x = 0; x < this->width; x++) {
+            alive += (this->lane(this->curr, x, y)[index / 64] >> (index % 64)) & 1;
+        }
+    }
+    return alive;
+}
+
+/**
+ * SlicedWorlds::lane(lanes, x, y)
+ *
+ * Private helper which gets the lane of the cell at (x, y) of a state, skipping the border.
+ */
+uint64_t* SlicedWorlds::lane(std::vector<uint64_t> &lanes, const unsigned int x, const unsigned int y) {
+    return lanes.data() + ((size_t)(y + 1) * (this->width + 2) + (x + 1)) * LANE_WORDS;
+}
+
+const uint64_t* SlicedWorlds::lane(const std::vector<uint64_t> &lanes, const unsigned int x, const unsigned int y) const {
+    return lanes.data() + ((size_t)(y + 1) * (this->width + 2) + (x + 1)) * LANE_WORDS;
+}
+
+bool SlicedWorlds::is_valid_index(const unsigned int index) const {
+    return index < CAPACITY;
+}
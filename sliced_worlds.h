@@ -0,0 +1,60 @@
+/**
+ * Declares a class representing up to 256 small worlds of the same size, bit-sliced so they step in lockstep.
+ * Rich documentation for the api and behaviour the SlicedWorlds class can be found in sliced_worlds.cpp.
+ */
+#pragma once
+#include "grid.h"
+#include "rule.h"
+#include <vector>
+#include <cstdint>
+
+/**
+ * Declare the structure of the SlicedWorlds class for stepping many tiny worlds with one pass of bitwise logic.
+ *
+ * Each cell is a lane of LANE_WORDS 64 bit words, and bit k of the lane is that cell in world k, so the bitwise
+ * logic of bitlogic.h applied to the lanes of a cell and its neighbours steps that cell in every world at once.
+ * With AVX2 a lane is 4 words, one 256 bit register, otherwise it is a single word.
+ *
+ * The lanes are stored with a one cell border, which is dead for bounded worlds or a copy of the opposite edge
+ * for toroidal ones, so the kernel has no boundary branches.
+ */
+class SlicedWorlds {
+    public:
+#if defined(__AVX2__)
+        static const unsigned int LANE_WORDS = 4;
+#else
+        static const unsigned int LANE_WORDS = 1;
+#endif
+        static const unsigned int CAPACITY = 64 * LANE_WORDS;
+
+    private:
+        unsigned int width;
+        unsigned int height;
+        std::vector<uint64_t> curr;
+        std::vector<uint64_t> next;
+        Rule rule;
+
+        uint64_t* lane(std::vector<uint64_t> &lanes, const unsigned int x, const unsigned int y);
+        const uint64_t* lane(const std::vector<uint64_t> &lanes, const unsigned int x, const unsigned int y) const;
+        bool is_valid_index(const unsigned int index) const;
+        void refresh_border(const bool torodial);
+
+    public:
+        SlicedWorlds();
+        explicit SlicedWorlds(const unsigned int square_size);
+        SlicedWorlds(const unsigned int width, const unsigned int height);
+
+        unsigned int get_width() const;
+        unsigned int get_height() const;
+        Grid get_state(const unsigned int index) const;
+        void set_state(const unsigned int index, const Grid &grid);
+        void pack(const std::vector<Grid> &grids);
+        std::vector<Grid> unpack(const unsigned int count = CAPACITY) const;
+        void enumerate(const unsigned long long first);
+        Rule get_rule() const;
+        void set_rule(const Rule &rule);
+        void step(const bool torodial = false);
+        void advance(const unsigned long long steps, const bool torodial = false);
+        unsigned int get_alive_cells(const unsigned int index) const;
+
+};
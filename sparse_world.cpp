@@ -0,0 +1,447 @@
+/**
+ * Implements a class representing an unbounded sparse world for simulating the Game of Life.
+ *      - The world has no edges, patterns such as gliders and spaceships travel forever.
+ *      - Cells are addressed with signed 64 bit coordinates, and all cells start Cell::DEAD.
+ *
+ *      - The world is divided into chunks of 64x64 cells, and only chunks with alive cells are stored.
+ *          - A chunk is allocated when activity reaches its border from a neighbouring chunk.
+ *          - A chunk is freed as soon as all of its cells are dead.
+ *          - Memory therefore scales with the live population, not with the area of its bounding box.
+ *
+ *      - Each chunk stores a row of 64 cells per uint64_t and is stepped 64 cells at a time, see bitlogic.h.
+ *
+ *      - Any rectangle of the world can be exported to a regular Grid, following the semantics of Grid::crop.
+ */
+#include "sparse_world.h"
+#include "bitlogic.h"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * SparseWorld::SparseWorld()
+ *
+ * Construct an empty unbounded world.
+ *
+ * @example
+ *
+ *      // Make an empty world
+ *      SparseWorld world;
+ *
+ */
+SparseWorld::SparseWorld() : population(0) {
+}
+
+/**
+ * SparseWorld::SparseWorld(initial_state, x0, y0)
+ *
+ * Construct an unbounded world containing the alive cells of a grid, with the top left of the grid at (x0, y0).
+ *
+ * @example
+ *
+ *      // Launch a light weight spaceship from the origin
+ *      SparseWorld world(Zoo::light_weight_spaceship());
+ *
+ * @param initial_state
+ *      The grid of cells to place in the world.
+ *
+ * @param x0
+ *      Optional parameter. The x coordinate of the top left of the grid. Defaults to 0.
+ *
+ * @param y0
+ *      Optional parameter. The y coordinate of the top left of the grid. Defaults to 0.
+ */
+SparseWorld::SparseWorld(const Grid &initial_state, const int64_t x0, const int64_t y0) : SparseWorld() {
+    this->merge(initial_state, x0, y0);
+}
+
+/**
+ * SparseWorld::get_alive_cells()
+ *
+ * Gets the number of alive cells in the world. The count is kept up to date by every step.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+uint64_t SparseWorld::get_alive_cells() const {
+    return this->population;
+}
+
+/**
+ * SparseWorld::get_chunk_count()
+ *
+ * Gets the number of chunks currently allocated.
+ *
+ * @return
+ *      The number of chunks.
+ */
+size_t SparseWorld::get_chunk_count() const {
+    return this->chunks.size();
+}
+
+/**
+ * SparseWorld::get_bounds(x0, y0, x1, y1)
+ *
+ * Computes the bounding box of all alive cells, as the range [x0, x1) by [y0, y1).
+ *
+ * @example
+ *
+ *      // Export everything that is alive
+ *      int64_t x0, y0, x1, y1;
+ *      if (world.get_bounds(x0, y0, x1, y1)) {
+ *          std::cout << world.crop(x0, y0, x1, y1) << std::endl;
+ *      }
+ *
+ * @return
+ *      False if there are no alive cells, in which case the bounds are not written.
+ */
+bool SparseWorld::get_bounds(int64_t &x0, int64_t &y0, int64_t &x1, int64_t &y1) const {
+    bool found = false;
+    for (const auto &entry : this->chunks) {
+        const int64_t base_x = entry.first.x * CHUNK_SIZE;
+        const int64_t base_y = entry.first.y * CHUNK_SIZE;
+        for (unsigned int y = 0; y < CHUNK_SIZE; y++) {
+            const uint64_t word = entry.second[y];
+            if (word == 0) {
+                continue;
+            }
+            const int64_t first = base_x + __builtin_ctzll(word);
+            const int64_t last = base_x + 63 - __builtin_clzll(word);
+            if (!found) {
+                x0 = first;
+                x1 = last + 1;
+                y0 = base_y + y;
+                y1 = base_y + y + 1;
+                found = true;
+            }
+            else {
+                x0 = std::min(x0, first);
+                x1 = std::max(x1, last + 1);
+                y0 = std::min(y0, base_y + (int64_t)y);
+                y1 = std::max(y1, base_y + (int64_t)y + 1);
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * SparseWorld::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate. Every coordinate is valid.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      The value of the cell, Cell::ALIVE or Cell::DEAD.
+ */
+Cell SparseWorld::get(const int64_t x, const int64_t y) const {
+    const int64_t chunk_x = chunk_coordinate(x);
+    const int64_t chunk_y = chunk_coordinate(y);
+    const Chunk *chunk = this->find(chunk_x, chunk_y);
+    if (chunk == nullptr) {
+        return Cell::DEAD;
+    }
+    const uint64_t word = (*chunk)[y - chunk_y * CHUNK_SIZE];
+    return ((word >> (x - chunk_x * CHUNK_SIZE)) & 1) ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * SparseWorld::set(x, y, cell)
+ *
+ * Overwrites the value at the desired coordinate, allocating or freeing its chunk as needed.
+ *
+ * @example
+ *
+ *      // Make a blinker far away from the origin
+ *      SparseWorld world;
+ *      world.set(1000000, 1000000, Cell::ALIVE);
+ *      world.set(1000001, 1000000, Cell::ALIVE);
+ *      world.set(1000002, 1000000, Cell::ALIVE);
+ *
+ * @param x
+ *      The x coordinate of the cell to update.
+ *
+ * @param y
+ *      The y coordinate of the cell to update.
+ *
+ * @param cell
+ *      The value to be written to the cell.
+ */
+void SparseWorld::set(const int64_t x, const int64_t y, Cell cell) {
+    const ChunkKey key{chunk_coordinate(x), chunk_coordinate(y)};
+    const uint64_t bit = (uint64_t)1 << (x - key.x * CHUNK_SIZE);
+    auto found = this->chunks.find(key);
+
+    if (cell == Cell::ALIVE) {
+        if (found == this->chunks.end()) {
+            found = this->chunks.emplace(key, Chunk{}).first;
+        }
+        uint64_t &word = found->second[y - key.y * CHUNK_SIZE];
+        if (!(word & bit)) {
+            word |= bit;
+            this->population++;
+        }
+        return;
+    }
+
+    if (found == this->chunks.end()) {
+        return;
+    }
+    uint64_t &word = found->second[y - key.y * CHUNK_SIZE];
+    if (word & bit) {
+        word &= ~bit;
+        this->population--;
+    }
+    for (const uint64_t row : found->second) {
+        if (row != 0) {
+            return;
+        }
+    }
+    this->chunks.erase(found);
+}
+
+/**
+ * SparseWorld::merge(other, x0, y0)
+ *
+ * Copy the alive cells of a grid into the world with the top left of the grid at (x0, y0).
+ * Cells which are dead in the grid are left unchanged, like Grid::merge with alive_only = true.
+ *
+ * @param other
+ *      The grid to merge into the world.
+ *
+ * @param x0
+ *      The x coordinate of the top left of the grid.
+ *
+ * @param y0
+ *      The y coordinate of the top left of the grid.
+ */
+void SparseWorld::merge(const Grid &other, const int64_t x0, const int64_t y0) {
+    for (unsigned int y = 0; y < other.get_height(); y++) {
+        const Cell *cells = other.row(y);
+        for (unsigned int x = 0; x < other.get_width(); x++) {
+            if (cells[x] == Cell::ALIVE) {
+                this->set(x0 + x, y0 + y, Cell::ALIVE);
+            }
+        }
+    }
+}
+
+/**
+ * SparseWorld::step()
+ *
+ * Take one step in Conway's Game of Life.
+ *
+ * Every allocated chunk is stepped, along with each missing neighbour chunk that an alive cell on the border
+ * of an allocated chunk could give birth into. Chunks whose cells all end up dead are not kept.
+ */
+void SparseWorld::step() {
+    std::unordered_map<ChunkKey, Chunk, ChunkKeyHash> next_chunks;
+    next_chunks.reserve(this->chunks.size());
+    std::vector<ChunkKey> candidates;
+
+    for (const auto &entry : this->chunks) {
+        const Chunk &chunk = entry.second;
+        uint64_t left = 0;
+        uint64_t right = 0;
+        for (const uint64_t row : chunk) {
+            left |= row & 1;
+            right |= row >> 63;
+        }
+        const bool top = chunk[0] != 0;
+        const bool bottom = chunk[CHUNK_SIZE - 1] != 0;
+        const int64_t x = entry.first.x;
+        const int64_t y = entry.first.y;
+
+        candidates.push_back(entry.first);
+        if (top) candidates.push_back(ChunkKey{x, y - 1});
+        if (bottom) candidates.push_back(ChunkKey{x, y + 1});
+        if (left) candidates.push_back(ChunkKey{x - 1, y});
+        if (right) candidates.push_back(ChunkKey{x + 1, y});
+        if (chunk[0] & 1) candidates.push_back(ChunkKey{x - 1, y - 1});
+        if (chunk[0] >> 63) candidates.push_back(ChunkKey{x + 1, y - 1});
+        if (chunk[CHUNK_SIZE - 1] & 1) candidates.push_back(ChunkKey{x - 1, y + 1});
+        if (chunk[CHUNK_SIZE - 1] >> 63) candidates.push_back(ChunkKey{x + 1, y + 1});
+    }
+
+    uint64_t population = 0;
+    for (const ChunkKey &key : candidates) {
+        if (next_chunks.count(key)) {
+            continue;
+        }
+        Chunk next;
+        if (this->step_chunk(key, next)) {
+            for (const uint64_t row : next) {
+                population += __builtin_popcountll(row);
+            }
+            next_chunks.emplace(key, next);
+        }
+    }
+
+    this->chunks.swap(next_chunks);
+    this->population = population;
+}
+
+/**
+ * SparseWorld::advance(steps)
+ *
+ * Advance multiple steps in the Game of Life, by invoking SparseWorld::step().
+ *
+ * @param steps
+ *      The number of steps to advance the world forward.
+ */
+void SparseWorld::advance(const unsigned long long steps) {
+    for (unsigned long long i = 0; i < steps; i++) {
+        this->step();
+    }
+}
+
+/**
+ * SparseWorld::crop(x0, y0, x1, y1)
+ *
+ * Export a rectangle of the world to a new Grid.
+ * The exported grid spans the range [x0, x1) by [y0, y1) in the world, like Grid::crop(x0, y0, x1, y1),
+ * except that every rectangle lies within the unbounded world.
+ *
+ * @example
+ *
+ *      // Export the 3x3 window where a glider will be after 400 steps
+ *      SparseWorld world(Zoo::glider());
+ *      world.advance(400);
+ *      Grid grid = world.crop(100, 100, 103, 103);
+ *
+ * @param x0
+ *      Left coordinate of the crop window on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the crop window on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the crop window on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the crop window on y-axis (1 greater than the largest index).
+ *
+ * @return
+ *      A new grid of the cropped size containing the cells of the world in the window.
+ *
+ * @throws
+ *      std::invalid_argument if the crop window has a negative size or is too large for a Grid.
+ */
+Grid SparseWorld::crop(const int64_t x0, const int64_t y0, const int64_t x1, const int64_t y1) const {
+    if (x0 > x1 || y0 > y1) {
+        throw std::invalid_argument("crop() : Negative size of crop window.");
+    }
+    if (x1 - x0 > UINT32_MAX || y1 - y0 > UINT32_MAX) {
+        throw std::invalid_argument("crop() : Crop window is too large.");
+    }
+    Grid grid((unsigned int)(x1 - x0), (unsigned int)(y1 - y0));
+
+    for (const auto &entry : this->chunks) {
+        const int64_t base_x = entry.first.x * CHUNK_SIZE;
+        const int64_t base_y = entry.first.y * CHUNK_SIZE;
+        if (base_x >= x1 || base_y >= y1 || base_x + CHUNK_SIZE <= x0 || base_y + CHUNK_SIZE <= y0) {
+            continue;
+        }
+        for (unsigned int y = 0; y < CHUNK_SIZE; y++) {
+            const int64_t cell_y = base_y + y;
+            if (cell_y < y0 || cell_y >= y1) {
+                continue;
+            }
+            for (uint64_t word = entry.second[y]; word != 0; word &= word - 1) {
+                const int64_t cell_x = base_x + __builtin_ctzll(word);
+                if (cell_x >= x0 && cell_x < x1) {
+                    grid.row(cell_y - y0)[cell_x - x0] = Cell::ALIVE;
+                }
+            }
+        }
+    }
+    return grid;
+}
+
+bool SparseWorld::ChunkKey::operator==(const ChunkKey &other) const {
+    return x == other.x && y == other.y;
+}
+
+size_t SparseWorld::ChunkKeyHash::operator()(const ChunkKey &key) const {
+    const uint64_t hash = (uint64_t)key.x * 0x9E3779B97F4A7C15ULL ^ ((uint64_t)key.y + 0x632BE59BD9B4E019ULL);
+    return (size_t)(hash ^ (hash >> 31));
+}
+
+/**
+ * SparseWorld::chunk_coordinate(coordinate)
+ *
+ * Private helper which returns the chunk containing a cell coordinate, rounding towards negative infinity.
+ */
+int64_t SparseWorld::chunk_coordinate(const int64_t coordinate) {
+    if (coordinate >= 0) {
+        return coordinate / CHUNK_SIZE;
+    }
+    return -((-(coordinate + 1)) / CHUNK_SIZE) - 1;
+}
+
+/**
+ * SparseWorld::find(chunk_x, chunk_y)
+ *
+ * Private helper which returns the chunk at the given chunk coordinates, or nullptr if it is not allocated.
+ */
+const SparseWorld::Chunk* SparseWorld::find(const int64_t chunk_x, const int64_t chunk_y) const {
+    auto found = this->chunks.find(ChunkKey{chunk_x, chunk_y});
+    if (found == this->chunks.end()) {
+        return nullptr;
+    }
+    return &found->second;
+}
+
+/**
+ * SparseWorld::step_chunk(key, next)
+ *
+ * Private helper which computes the next generation of one chunk from it and its 8 neighbouring chunks.
+ *
+ * @return
+ *      True if any cell of the chunk is alive in the next generation.
+ */
+bool SparseWorld::step_chunk(const ChunkKey &key, Chunk &next) const {
+    // neighbourhood[dy + 1][dx + 1] is the chunk at (key.x + dx, key.y + dy), or nullptr
+    const Chunk *neighbourhood[3][3];
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            neighbourhood[dy + 1][dx + 1] = this->find(key.x + dx, key.y + dy);
+        }
+    }
+
+    // row(column, y) is row y (from -1 to CHUNK_SIZE) of the chunk in the given column of the neighbourhood
+    auto row = [&](const int column, const int y) -> uint64_t {
+        int chunk_row = 1;
+        int index = y;
+        if (y < 0) {
+            chunk_row = 0;
+            index = CHUNK_SIZE - 1;
+        }
+        else if (y >= (int)CHUNK_SIZE) {
+            chunk_row = 2;
+            index = 0;
+        }
+        const Chunk *chunk = neighbourhood[chunk_row][column];
+        return chunk == nullptr ? 0 : (*chunk)[index];
+    };
+
+    uint64_t any = 0;
+    for (int y = 0; y < (int)CHUNK_SIZE; y++) {
+        uint64_t west[3], centre[3], east[3];
+        for (int r = 0; r < 3; r++) {
+            centre[r] = row(1, y + r - 1);
+            west[r] = (centre[r] << 1) | (row(0, y + r - 1) >> 63);
+            east[r] = (centre[r] >> 1) | (row(2, y + r - 1) << 63);
+        }
+        const BitLogic::Counts counts = BitLogic::count_neighbours(west[0], centre[0], east[0],
+            west[1], east[1], west[2], centre[2], east[2]);
+        next[y] = BitLogic::conway(counts, centre[1]);
+        any |= next[y];
+    }
+    return any != 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * Declares a class representing an unbounded sparse world for simulating the Game of Life.
+ * Rich documentation for the api and behaviour the SparseWorld class can be found in sparse_world.cpp.
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include "grid.h"
+
+/**
+ * Declare the structure of the SparseWorld class for representing an unbounded 2d world.
+ *
+ * Only chunks of CHUNK_SIZE x CHUNK_SIZE cells containing alive cells are stored, in a hash map keyed by
+ * chunk coordinates. Each chunk is bit-packed, one 64 bit word per row.
+ */
+class SparseWorld {
+    public:
+        static const unsigned int CHUNK_SIZE = 64;
+
+    private:
+        typedef std::array<uint64_t, CHUNK_SIZE> Chunk;
+
+        struct ChunkKey {
+            int64_t x;
+            int64_t y;
+            bool operator==(const ChunkKey &other) const;
+        };
+
+        struct ChunkKeyHash {
+            size_t operator()(const ChunkKey &key) const;
+        };
+
+        std::unordered_map<ChunkKey, Chunk, ChunkKeyHash> chunks;
+        uint64_t population;
+
+        static int64_t chunk_coordinate(const int64_t coordinate);
+        const Chunk* find(const int64_t chunk_x, const int64_t chunk_y) const;
+        bool step_chunk(const ChunkKey &key, Chunk &next) const;
+
+    public:
+        SparseWorld();
+        explicit SparseWorld(const Grid &initial_state, const int64_t x0 = 0, const int64_t y0 = 0);
+
+        uint64_t get_alive_cells() const;
+        size_t get_chunk_count() const;
+        bool get_bounds(int64_t &x0, int64_t &y0, int64_t &x1, int64_t &y1) const;
+        Cell get(const int64_t x, const int64_t y) const;
+        void set(const int64_t x, const int64_t y, Cell cell);
+        void merge(const Grid &other, const int64_t x0, const int64_t y0);
+        void step();
+        void advance(const unsigned long long steps);
+        Grid crop(const int64_t x0, const int64_t y0, const int64_t x1, const int64_t y1) const;
+
+};
@@ -0,0 +1,158 @@
+/**
+ * Implements a class representing a persistent pool of worker threads.
+ *      - Pools are constructed with a fixed number of threads, including the thread that calls run.
+ *      - Running a batch of tasks blocks until every task has finished, acting as a barrier.
+ *      - Tasks are handed out one index at a time, so uneven tasks are balanced across the threads.
+ *      - The first exception thrown by a task is rethrown from ThreadPool::run(tasks, task).
+ */
+#include "threadpool.h"
+#include <algorithm>
+
+/**
+ * ThreadPool::ThreadPool(threads)
+ *
+ * Construct a pool that runs tasks on the desired number of threads.
+ * The calling thread takes part in running tasks, so (threads - 1) worker threads are started.
+ * A value of 0 uses one thread per hardware thread.
+ *
+ * @example
+ *
+ *      // Make a pool using 8 threads
+ *      ThreadPool pool(8);
+ *
+ * @param threads
+ *      The total number of threads to run tasks on.
+ */
+ThreadPool::ThreadPool(const unsigned int threads)
+    : task(nullptr), tasks(0), next_task(0), generation(0), busy_workers(0), stopping(false) {
+    unsigned int total = threads;
+    if (total == 0) {
+        total = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 1; i < total; i++) {
+        this->workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+/**
+ * ThreadPool::~ThreadPool()
+ *
+ * Wake and join every worker thread.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->work_ready.notify_all();
+    for (std::thread &worker : this->workers) {
+        worker.join();
+    }
+}
+
+/**
+ * ThreadPool::get_threads()
+ *
+ * Gets the total number of threads tasks run on, including the calling thread.
+ *
+ * @return
+ *      The number of threads.
+ */
+unsigned int ThreadPool::get_threads() const {
+    return (unsigned int)this->workers.size() + 1;
+}
+
+/**
+ * ThreadPool::run(tasks, task)
+ *
+ * Invoke task(i) for every i in [0, tasks) across the threads of the pool and wait for all of them to finish.
+ * Calls from several threads at once are serialized.
+ *
+ * @example
+ *
+ *      // Fill a vector in parallel, one band of 1024 elements per task
+ *      std::vector<int> values(1024 * 64);
+ *      pool.run(64, [&](unsigned int band) {
+ *          for (unsigned int i = band * 1024; i < (band + 1) * 1024; i++) {
+ *              values[i] = i;
+ *          }
+ *      });
+ *
+ * @param tasks
+ *      The number of tasks to run.
+ *
+ * @param task
+ *      The function to invoke with the index of each task.
+ *
+ * @throws
+ *      The first exception thrown by any task, once every task has finished.
+ */
+void ThreadPool::run(const unsigned int tasks, const std::function<void(unsigned int)> &task) {
+    std::lock_guard<std::mutex> run_lock(this->run_mutex);
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = &task;
+        this->tasks = tasks;
+        this->next_task = 0;
+        this->error = nullptr;
+        this->busy_workers = (unsigned int)this->workers.size();
+        this->generation++;
+    }
+    this->work_ready.notify_all();
+
+    this->run_tasks();
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->work_done.wait(lock, [this] { return this->busy_workers == 0; });
+    this->task = nullptr;
+    if (this->error) {
+        std::rethrow_exception(this->error);
+    }
+}
+
+/**
+ * ThreadPool::run_tasks()
+ *
+ * Private helper that claims and runs task indices until none are left.
+ */
+void ThreadPool::run_tasks() {
+    for (unsigned int i = this->next_task++; i < this->tasks; i = this->next_task++) {
+        try {
+            (*this->task)(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->error) {
+                this->error = std::current_exception();
+            }
+        }
+    }
+}
+
+/**
+ * ThreadPool::worker_loop()
+ *
+ * Private helper run by each worker thread. Sleeps until a new batch of tasks is published,
+ * helps run it, then reports back to ThreadPool::run(tasks, task).
+ */
+void ThreadPool::worker_loop() {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->work_ready.wait(lock, [this, seen] { return this->stopping || this->generation != seen; });
+            if (this->stopping) {
+                return;
+            }
+            seen = this->generation;
+        }
+
+        this->run_tasks();
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->busy_workers--;
+        }
+        this->work_done.notify_one();
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * Declares a class representing a persistent pool of worker threads.
+ * Rich documentation for the api and behaviour the ThreadPool class can be found in threadpool.cpp.
+ */
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+/**
+ * Declare the structure of the ThreadPool class for running indexed tasks in parallel.
+ *
+ * The worker threads are created once and sleep between calls to ThreadPool::run(tasks, task),
+ * so the cost of creating threads is not paid every time work is handed out.
+ */
+class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::mutex run_mutex;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+        const std::function<void(unsigned int)> *task;
+        unsigned int tasks;
+        std::atomic<unsigned int> next_task;
+        unsigned long long generation;
+        unsigned int busy_workers;
+        bool stopping;
+        std::exception_ptr error;
+
+        void worker_loop();
+        void run_tasks();
+
+    public:
+        explicit ThreadPool(const unsigned int threads);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool& operator=(const ThreadPool &other) = delete;
+
+        unsigned int get_threads() const;
+        void run(const unsigned int tasks, const std::function<void(unsigned int)> &task);
+
+};
@@ -11,20 +11,34 @@
  *      - Stepping a world forward in time applies the rules of Conway's Game of Life.
  *          - https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
  *
- *      - Worlds have a private helper function used to count the number of alive cells in a 3x3 neighbours
- *        around a given cell.
+ *      - Worlds step in tiles of 64x64 cells, evaluating only the tiles which changed or border one that did.
+ *          - The state is mirrored in a halo buffer with a one cell ghost border, dead or wrapped on a torus.
+ *          - A vectorized row kernel computes each row from the halo rows around it, with no boundary branches.
  *
  *      - Updating the world state can conditionally be performed using a toroidal topology.
  *          - Moving off the left edge you appear on the right edge and vice versa.
  *          - Moving off the top edge you appear on the bottom edge and vice versa.
  *
+ *      - Worlds can be stepped by different engines which all produce the same generations.
+ *          - World::Engine::CELLS works directly on the current state grid.
+ *          - World::Engine::BITS works on a bit-packed copy of the state, see bitgrid.cpp.
+ *          - World::Engine::TABLE works directly on the current state grid with a lookup table, see blocktable.cpp.
+ *          - World::Engine::HASHLIFE is the exception, it simulates the unbounded plane, see hashlife.cpp.
+ *
  * @author 966022
  * @date March, 2020
  */
 #include "world.h"
+#include "bitgrid.h"
+#include "blocktable.h"
+#include "hashlife.h"
+#include <stdexcept>
 #include <algorithm>
-//TODO remove counts
-#include <iostream>
+#include <vector>
+#include <atomic>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // Include the minimal number of headers needed to support your implementation.
 // #include ...
@@ -81,9 +95,13 @@ World::World(const unsigned int square_size) : World(square_size, square_size){
  * @param height
  *      The height of the world.
  */
-World::World(const unsigned int width, const unsigned int height) {
+World::World(const unsigned int width, const unsigned int height)
+    : engine(Engine::CELLS), pool(nullptr), halo_torodial(false), block_table(nullptr),
+      generation(0), max_period(0), tile_hash_valid(false), state_hash(0), history_valid(false), history_start(0),
+      cycle_torodial(false), period(0), cycle_start(0) {
     this->currGrid = Grid(width, height);
     this->nextGrid = Grid(width, height);
+    this->mark_all_changed();
 }
 
 
@@ -107,13 +125,10 @@ World::World(const unsigned int width, const unsigned int height) {
  *      The state of the constructed world.
  */
 World::World(const Grid initial_state) : World(initial_state.get_width(), initial_state.get_height()) {
-    for (unsigned int y = 0; y < initial_state.get_height(); y++) {
-        for (unsigned int x = 0; x < initial_state.get_width(); x++) {
-            this->currGrid(x, y) = initial_state(x, y);
-            this->nextGrid(x, y) = initial_state(x, y);
-        }
-    }
-
+    const Cell *cells = initial_state.data();
+    std::copy(cells, cells + initial_state.get_total_cells(), this->currGrid.data());
+    std::copy(cells, cells + initial_state.get_total_cells(), this->nextGrid.data());
+    this->mark_all_changed();
 }
 
 
@@ -205,6 +220,9 @@ unsigned int World::get_total_cells() const {
  * Counts how many cells in the world are alive.
  * The function should be callable from a constant context.
  *
+ * The count is maintained as the world changes, using the births and deaths computed by each step,
+ * so this takes constant time.
+ *
  * @example
  *
  *      // Make a world
@@ -223,7 +241,7 @@ unsigned int World::get_total_cells() const {
  *      The number of alive cells.
  */
 unsigned int World::get_alive_cells() const {
-    return this->currGrid.get_alive_cells();
+    return this->population;
 }
 
 /**
@@ -231,6 +249,7 @@ unsigned int World::get_alive_cells() const {
  *
  * Counts how many cells in the world are dead.
  * The function should be callable from a constant context.
+ * Takes constant time, see World::get_alive_cells().
  *
  * @example
  *
@@ -250,7 +269,53 @@ unsigned int World::get_alive_cells() const {
  *      The number of dead cells.
  */
 unsigned int World::get_dead_cells() const {
-    return this->currGrid.get_dead_cells();
+    return this->get_total_cells() - this->population;
+}
+
+/**
+ * World::get_births()
+ *
+ * Gets how many dead cells became alive in the last step, or over the last call to World::advance(steps, toroidal).
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of births in the last call to World::step(toroidal), summed over the generations stepped one at
+ *      a time by the last call to World::advance(steps, toroidal) and leaving out those skipped over as cycles,
+ *      or 0 after any other change to the world.
+ */
+unsigned int World::get_births() const {
+    return this->births;
+}
+
+/**
+ * World::get_deaths()
+ *
+ * Gets how many alive cells became dead in the last step, or over the last call to World::advance(steps, toroidal).
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of deaths in the last call to World::step(toroidal), summed over the generations stepped one at
+ *      a time by the last call to World::advance(steps, toroidal) and leaving out those skipped over as cycles,
+ *      or 0 after any other change to the world.
+ */
+unsigned int World::get_deaths() const {
+    return this->deaths;
+}
+
+/**
+ * World::get_active_tiles()
+ *
+ * Gets how many tiles of 64x64 cells the last step evaluated, see World::step(toroidal).
+ * Tiles which did not change and do not border a tile which changed are skipped, so on a world which is mostly
+ * settled this is far smaller than the number of tiles.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of tiles evaluated by the last call to World::step(toroidal), which is every tile with a
+ *      Larger than Life rule, or 0 after any other change to the world.
+ */
+unsigned int World::get_active_tiles() const {
+    return this->active_tiles;
 }
 
 /**
@@ -281,6 +346,219 @@ const Grid& World::get_state() const{
     return this->currGrid;
 }
 
+/**
+ * World::get_engine()
+ *
+ * Gets the engine used to step the world forward.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The current engine, World::Engine::CELLS unless changed with World::set_engine(engine).
+ */
+World::Engine World::get_engine() const {
+    return this->engine;
+}
+
+/**
+ * World::set_engine(engine)
+ *
+ * Selects the engine used by World::step(toroidal) and World::advance(steps, toroidal).
+ * World::Engine::CELLS, World::Engine::BITS and World::Engine::TABLE produce the same generations,
+ * they only differ in speed and memory use.
+ *
+ * World::Engine::BITS packs the current state into a BitGrid once per call to World::advance(steps, toroidal),
+ * steps it 64 cells at a time, and unpacks the result. It pays off when advancing many steps per call.
+ *
+ * World::Engine::TABLE steps the current state like World::Engine::CELLS, but computes each 2x2 block of cells
+ * with a single lookup in a precomputed table, see blocktable.cpp. It needs no SIMD instructions, so it is the
+ * portable alternative on machines without SSE2 or AVX2.
+ *
+ * World::Engine::HASHLIFE builds a HashLife quadtree of the current state on the first call to
+ * World::advance(steps, toroidal), which runs in roughly logarithmic time in the number of steps for
+ * patterns that settle into repetition. It simulates the unbounded plane: cells are not lost at the
+ * edge of the world and may be born outside of it, and the world shows the window of the plane it covers.
+ * The quadtree is kept by later calls, so a run gives the same result however it is split into calls.
+ * Changing the engine, the rule or the size of the world, or stepping it on another engine, starts the plane
+ * again from the window, as does advancing a copy of the world which still shares its plane with another.
+ * It does not support the toroidal topology.
+ *
+ * @example
+ *
+ *      // Make a world
+ *      World world(Zoo::r_pentomino());
+ *
+ *      // Advance 1000 steps on the bit-packed engine
+ *      world.set_engine(World::Engine::BITS);
+ *      world.advance(1000);
+ *
+ * @param engine
+ *      The engine to use from now on.
+ */
+void World::set_engine(const Engine engine) {
+    if (engine != this->engine) {
+        this->hashlife.reset();
+    }
+    this->engine = engine;
+}
+
+/**
+ * World::get_rule()
+ *
+ * Gets the rule the world is stepped with.
+ *
+ * @return
+ *      The current rule, B3/S23 unless changed with World::set_rule(rule).
+ */
+Rule World::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * World::set_rule(rule)
+ *
+ * Selects the Life-like rule used by World::step(toroidal) and World::advance(steps, toroidal), on every engine.
+ *
+ * B3/S23 (Conway), B36/S23 (HighLife), B3678/S34678 (Day & Night) and B2/S (Seeds) have kernels specialized
+ * at compile time, so they step as fast as each other. Other rules are read at run time by the kernels.
+ *
+ * Replaces any Larger than Life rule set with World::set_rule(rule). Every tile is evaluated in the next step,
+ * as a quiescent region under one rule need not be quiescent under another.
+ *
+ * @example
+ *
+ *      // Make a world
+ *      World world(Zoo::r_pentomino());
+ *
+ *      // Step it in HighLife
+ *      world.set_rule(Rule("B36/S23"));
+ *      world.step();
+ *
+ * @param rule
+ *      The rule to use from now on.
+ */
+void World::set_rule(const Rule &rule) {
+    this->rule = rule;
+    this->extended_rule.reset();
+    this->hashlife.reset();
+    this->mark_all_changed();
+    this->reset_cycle();
+}
+
+/**
+ * World::get_extended_rule()
+ *
+ * Gets the Larger than Life rule the world is stepped with, if there is one.
+ *
+ * @return
+ *      A read-only pointer to the Larger than Life rule, or nullptr if the world uses a Life-like rule,
+ *      see World::get_rule(). Valid until the rule is next changed.
+ */
+const LargerThanLifeRule* World::get_extended_rule() const {
+    return this->extended_rule ? &*this->extended_rule : nullptr;
+}
+
+/**
+ * World::set_rule(rule)
+ *
+ * Selects a Larger than Life rule, with a radius R neighbourhood, used by World::step(toroidal) and
+ * World::advance(steps, toroidal) until a Life-like rule is set again.
+ *
+ * These steps are computed from a summed-area table of the current state, so counting the (2R + 1)^2
+ * neighbourhood of a cell takes 4 reads whatever the radius, see World::step_extended(toroidal).
+ * The engine is not used while a Larger than Life rule is set, since every engine is built around the
+ * 3x3 neighbourhood.
+ *
+ * @example
+ *
+ *      // Make a world
+ *      World world(512, 512);
+ *
+ *      // Step it in Bugs
+ *      world.set_rule(LargerThanLifeRule("R5,C0,M1,S34..58,B34..45,NM"));
+ *      world.step(true);
+ *
+ * @param rule
+ *      The rule to use from now on.
+ */
+void World::set_rule(const LargerThanLifeRule &rule) {
+    this->extended_rule = rule;
+    this->hashlife.reset();
+    this->mark_all_changed();
+    this->reset_cycle();
+}
+
+/**
+ * World::get_threads()
+ *
+ * Gets the number of threads used to step the world forward.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of threads, 1 unless changed with World::set_threads(threads).
+ */
+unsigned int World::get_threads() const {
+    if (this->pool) {
+        return this->pool->get_threads();
+    }
+    return 1;
+}
+
+/**
+ * World::set_threads(threads)
+ *
+ * Selects how many threads World::step(toroidal) and World::advance(steps, toroidal) run on.
+ * The threads are created here and persist until the thread count changes or the world is destroyed,
+ * so no threads are created while stepping. Copies of a world share its threads.
+ *
+ * Each step partitions the current state grid into one band of rows per thread. Every thread writes a disjoint
+ * band of the next state grid, and all threads join before the grids are swapped.
+ *
+ * @example
+ *
+ *      // Make a large world
+ *      World world(4096);
+ *
+ *      // Step it on 8 threads
+ *      world.set_threads(8);
+ *      world.advance(100);
+ *
+ * @param threads
+ *      The number of threads to use. 1 steps on the calling thread only, 0 uses one thread per hardware thread.
+ */
+void World::set_threads(const unsigned int threads) {
+    if (threads == 1) {
+        this->pool.reset();
+    }
+    else {
+        this->pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+/**
+ * World::for_each_band(count, band)
+ *
+ * Private helper which splits the range [0, count) into one band per thread and invokes band(i0, i1)
+ * for each band [i0, i1) on the thread pool, returning once every band is done.
+ * Without a thread pool the whole range is a single band run on the calling thread.
+ *
+ * @param count
+ *      The number of rows (or rows of tiles) to split.
+ *
+ * @param band
+ *      The function to invoke with the first index and one past the last index of each band.
+ */
+void World::for_each_band(const unsigned int count, const std::function<void(unsigned int, unsigned int)> &band) {
+    const unsigned int bands = std::min(this->get_threads(), count);
+    if (bands <= 1) {
+        band(0, count);
+        return;
+    }
+    this->pool->run(bands, [&](unsigned int i) {
+        band((unsigned int)((unsigned long long)count * i / bands),
+             (unsigned int)((unsigned long long)count * (i + 1) / bands));
+    });
+}
+
 /**
  * World::resize(square_size)
  *
@@ -329,114 +607,376 @@ void World::resize(const unsigned int square_size) {
 void World::resize(const unsigned int new_width, const unsigned int new_height) {
     this->currGrid.resize(new_width, new_height);
     this->nextGrid = Grid(new_width, new_height);
+    this->hashlife.reset();
+    this->mark_all_changed();
+    this->reset_cycle();
 }
 
 /**
- * World::count_neighbours(x, y, toroidal)
+ * DynamicRule
  *
- * Private helper function to count the number of alive neighbours of a cell.
- * The function should not be visible from outside the World class.
+ * A rule chosen at run time, with the same interface as StaticRule so the kernels can be written once.
+ */
+struct DynamicRule {
+    uint16_t birth;
+    uint16_t survival;
+};
+
+/**
+ * next_cell(rule, cell, neighbours)
  *
- * Neighbours are considered within the 3x3 square centred around the cell at x,y in the current state grid.
- * Ignore the centre coordinate, a cell is not its own neighbour.
- * Attempt to keep the logic as simple, expressive, and readable as possible.
+ * Apply a Life-like rule to a single cell.
  *
- * If toroidal = false then skip any neighbours that would be outside of the grid,
- * this assumes the grid is Cell::DEAD outside its bounds.
+ * @param rule
+ *      The rule, a StaticRule or a DynamicRule.
  *
- * If toroidal = true then correctly wrap out of bounds coordinates to the opposite side of the grid.
+ * @param cell
+ *      The current value of the cell.
  *
- * This function is in World and not Grid because the 3x3 sized neighbourhood is specific to Conway's Game of Life,
- * while Grid is more generic to any 2D grid based cellular automaton.
+ * @param neighbours
+ *      The number of alive neighbours of the cell.
  *
- * @param x
- *      The x coordinate of the centre of the neighbourhood.
+ * @return
+ *      The value of the cell in the next generation.
+ */
+template <typename RULE>
+static inline Cell next_cell(const RULE &rule, const Cell cell, const unsigned int neighbours) {
+    const uint16_t mask = (cell == Cell::ALIVE) ? rule.survival : rule.birth;
+    return ((mask >> neighbours) & 1) ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * count_change(before, after, births, deaths)
  *
- * @param y
- *      The y coordinate of the centre of the neighbourhood.
+ * Count a single cell towards the births or deaths of a step.
+ */
+static inline void count_change(const Cell before, const Cell after, unsigned int &births, unsigned int &deaths) {
+    births += (before == Cell::DEAD && after == Cell::ALIVE);
+    deaths += (before == Cell::ALIVE && after == Cell::DEAD);
+}
+
+/**
+ * step_row<RULE>(rule, up, row, down, out, x0, x1, births, deaths)
  *
- * @param toroidal
- *      If true then the step will consider the grid as a torus, where the left edge
- *      wraps to the right edge and the top to the bottom.
+ * Compute the next generation of columns [x0, x1) of a row, given the rows above and below it.
+ * The rows are rows of the padded halo buffer, so column -1 and column width are always readable
+ * and the kernel has no boundary branches at all.
  *
- * @return
- *      Returns the number of alive neighbours.
- */
-unsigned int World::count_neighbours(const unsigned int x, const unsigned int y, const bool torodial) const {
-    int x_minus = x - 1;
-    int x_plus = x + 1;
-    int y_minus = y - 1;
-    int y_plus = y + 1;
-    unsigned int counter = 0;
-    //the unsigned int and int casting are done to not get warnings
-    if(torodial){
-        if (x_minus == -1) {
-            x_minus = (int)this->get_width() - 1;
-        } 
-        else if (x_plus == (int)this->get_width()) {
-            x_plus = 0;
-        }
-        if (y_minus == -1) {
-            y_minus = this->get_height() - 1;
-        }
-        else if (y_plus == (int)this->get_height()) {
-            y_plus = 0;
-        }
-        int arraySize = 3;
-        unsigned int setX[arraySize] = {(unsigned int)x_minus, x, (unsigned int)x_plus};
-        unsigned int setY[arraySize] = {(unsigned int)y_minus, y, (unsigned int)y_plus};
-        for (int i = 0; i < arraySize; i++) {
-            for (int j = 0; j < arraySize; j++) {
-                if (this->currGrid(setX[j], setY[i]) == Cell::ALIVE) {
-                    counter++;
+ * The neighbour count for a block of cells is the sum of 8 unaligned loads of the three rows, each compared
+ * against Cell::ALIVE. A byte compare yields -1 for a match, so the sum is minus the neighbour count.
+ * The rule then becomes one compare per neighbour count it names, and a blend between Cell::ALIVE and Cell::DEAD.
+ * Counts in both the birth and survival sets need no mask of the centre cell, so B3/S23 is two compares.
+ * AVX2 handles 32 cells per instruction, SSE2 handles 16, and the remaining columns fall back to scalar code.
+ *
+ * With a StaticRule the masks are compile time constants, so the loops over the counts unroll and
+ * every compare the rule does not need disappears. With a DynamicRule they are tested per block of cells.
+ *
+ * Births and deaths are counted from the same compare masks, with a popcount of their byte masks.
+ *
+ * @param rule
+ *      The rule to apply, a StaticRule or a DynamicRule.
+ *
+ * @param up
+ *      The row above, pointing at column 0 of the padded row.
+ *
+ * @param row
+ *      The row being updated, pointing at column 0 of the padded row.
+ *
+ * @param down
+ *      The row below, pointing at column 0 of the padded row.
+ *
+ * @param out
+ *      The row of the next state grid to write to.
+ *
+ * @param x0
+ *      The first column to compute.
+ *
+ * @param x1
+ *      One past the last column to compute, at most width.
+ *
+ * @param births
+ *      Incremented by the number of dead cells which become alive.
+ *
+ * @param deaths
+ *      Incremented by the number of alive cells which become dead.
+ */
+template <typename RULE>
+static void step_row(const RULE &rule, const Cell *up, const Cell *row, const Cell *down, Cell *out,
+    const unsigned int x0, const unsigned int x1, unsigned int &births, unsigned int &deaths) {
+    const uint16_t birth = rule.birth;
+    const uint16_t survival = rule.survival;
+    unsigned int x = x0;
+
+#if defined(__AVX2__)
+    const __m256i alive = _mm256_set1_epi8((char)Cell::ALIVE);
+    const __m256i dead = _mm256_set1_epi8((char)Cell::DEAD);
+    for (; x + 32 <= x1; x += 32) {
+        #define ALIVE_MASK(p) _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p)), alive)
+        __m256i sum = _mm256_add_epi8(ALIVE_MASK(up + x - 1), ALIVE_MASK(up + x));
+        sum = _mm256_add_epi8(sum, ALIVE_MASK(up + x + 1));
+        sum = _mm256_add_epi8(sum, ALIVE_MASK(row + x - 1));
+        sum = _mm256_add_epi8(sum, ALIVE_MASK(row + x + 1));
+        sum = _mm256_add_epi8(sum, ALIVE_MASK(down + x - 1));
+        sum = _mm256_add_epi8(sum, ALIVE_MASK(down + x));
+        sum = _mm256_add_epi8(sum, ALIVE_MASK(down + x + 1));
+        const __m256i centre = ALIVE_MASK(row + x);
+        #undef ALIVE_MASK
+        __m256i either = _mm256_setzero_si256();
+        __m256i born = _mm256_setzero_si256();
+        __m256i kept = _mm256_setzero_si256();
+        // Fully unrolled, so for a StaticRule the tests of the masks fold away and only the compares it needs remain
+        #pragma GCC unroll 9
+        for (int n = 0; n <= 8; n++) {
+            const bool b = (birth >> n) & 1;
+            const bool s = (survival >> n) & 1;
+            if (b || s) {
+                const __m256i count = _mm256_cmpeq_epi8(sum, _mm256_set1_epi8((char)-n));
+                if (b && s) {
+                    either = _mm256_or_si256(either, count);
+                }
+                else if (b) {
+                    born = _mm256_or_si256(born, count);
+                }
+                else {
+                    kept = _mm256_or_si256(kept, count);
                 }
             }
         }
-
+        const __m256i next = _mm256_or_si256(either,
+            _mm256_or_si256(_mm256_andnot_si256(centre, born), _mm256_and_si256(centre, kept)));
+        _mm256_storeu_si256((__m256i*)(out + x), _mm256_blendv_epi8(dead, alive, next));
+        births += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_andnot_si256(centre, next)));
+        deaths += __builtin_popcount((unsigned int)_mm256_movemask_epi8(_mm256_andnot_si256(next, centre)));
     }
-    else {
-        if (x_minus == -1) {
-            x_minus++;
-        }
-        else if (x_plus == (int)this->get_width()) {
-            x_plus--;
-        }
-        if (y_minus == -1) {
-            y_minus++;
-        }
-        else if (y_plus == (int)this->get_height()) {
-            y_plus--;
-        }
-        for (int j = y_minus; j <= y_plus; j++) {
-            for (int i = x_minus; i <= x_plus; i++) {
-                if (this->currGrid(i, j) == Cell::ALIVE) {
-                    counter++;
+#endif
+
+#if defined(__SSE2__)
+    const __m128i alive_sse = _mm_set1_epi8((char)Cell::ALIVE);
+    const __m128i dead_sse = _mm_set1_epi8((char)Cell::DEAD);
+    for (; x + 16 <= x1; x += 16) {
+        #define ALIVE_MASK(p) _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p)), alive_sse)
+        __m128i sum = _mm_add_epi8(ALIVE_MASK(up + x - 1), ALIVE_MASK(up + x));
+        sum = _mm_add_epi8(sum, ALIVE_MASK(up + x + 1));
+        sum = _mm_add_epi8(sum, ALIVE_MASK(row + x - 1));
+        sum = _mm_add_epi8(sum, ALIVE_MASK(row + x + 1));
+        sum = _mm_add_epi8(sum, ALIVE_MASK(down + x - 1));
+        sum = _mm_add_epi8(sum, ALIVE_MASK(down + x));
+        sum = _mm_add_epi8(sum, ALIVE_MASK(down + x + 1));
+        const __m128i centre = ALIVE_MASK(row + x);
+        #undef ALIVE_MASK
+        __m128i either = _mm_setzero_si128();
+        __m128i born = _mm_setzero_si128();
+        __m128i kept = _mm_setzero_si128();
+        // Fully unrolled, so for a StaticRule the tests of the masks fold away and only the compares it needs remain
+        #pragma GCC unroll 9
+        for (int n = 0; n <= 8; n++) {
+            const bool b = (birth >> n) & 1;
+            const bool s = (survival >> n) & 1;
+            if (b || s) {
+                const __m128i count = _mm_cmpeq_epi8(sum, _mm_set1_epi8((char)-n));
+                if (b && s) {
+                    either = _mm_or_si128(either, count);
+                }
+                else if (b) {
+                    born = _mm_or_si128(born, count);
+                }
+                else {
+                    kept = _mm_or_si128(kept, count);
                 }
             }
         }
-        
+        const __m128i next = _mm_or_si128(either,
+            _mm_or_si128(_mm_andnot_si128(centre, born), _mm_and_si128(centre, kept)));
+        _mm_storeu_si128((__m128i*)(out + x),
+            _mm_or_si128(_mm_and_si128(next, alive_sse), _mm_andnot_si128(next, dead_sse)));
+        births += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_andnot_si128(centre, next)));
+        deaths += __builtin_popcount((unsigned int)_mm_movemask_epi8(_mm_andnot_si128(next, centre)));
     }
-    if (this->currGrid(x, y) == Cell::ALIVE) {
-        counter--;
+#endif
+
+    for (; x < x1; x++) {
+        const Cell *u = up + x, *r = row + x, *d = down + x;
+        const unsigned int neighbours =
+            (u[-1] == Cell::ALIVE) + (u[0] == Cell::ALIVE) + (u[1] == Cell::ALIVE) +
+            (r[-1] == Cell::ALIVE) + (r[1] == Cell::ALIVE) +
+            (d[-1] == Cell::ALIVE) + (d[0] == Cell::ALIVE) + (d[1] == Cell::ALIVE);
+        out[x] = next_cell(rule, row[x], neighbours);
+        count_change(row[x], out[x], births, deaths);
     }
-    
+}
 
-    
+/**
+ * RowKernel
+ *
+ * The step_row kernel for one rule, see select_row_kernel(rule).
+ */
+typedef void (*RowKernel)(const DynamicRule &rule, const Cell *up, const Cell *row, const Cell *down, Cell *out,
+    const unsigned int x0, const unsigned int x1, unsigned int &births, unsigned int &deaths);
 
-    return counter;
+/**
+ * step_row_static<RULE>(rule, up, row, down, out, x0, x1, births, deaths)
+ *
+ * The step_row kernel specialized on a StaticRule, with the signature of a RowKernel.
+ * The run time rule is ignored, it is the same rule.
+ */
+template <typename RULE>
+static void step_row_static(const DynamicRule &, const Cell *up, const Cell *row, const Cell *down, Cell *out,
+    const unsigned int x0, const unsigned int x1, unsigned int &births, unsigned int &deaths) {
+    step_row(RULE(), up, row, down, out, x0, x1, births, deaths);
 }
 
+/**
+ * select_row_kernel(rule)
+ *
+ * Pick the kernel specialized on a rule if there is one, otherwise the kernel which reads the rule at run time.
+ *
+ * @param rule
+ *      The rule of the world.
+ *
+ * @return
+ *      The kernel to step rows with.
+ */
+static RowKernel select_row_kernel(const Rule &rule) {
+    if (rule == Rule(ConwayRule())) {
+        return step_row_static<ConwayRule>;
+    }
+    if (rule == Rule(HighLifeRule())) {
+        return step_row_static<HighLifeRule>;
+    }
+    if (rule == Rule(DayAndNightRule())) {
+        return step_row_static<DayAndNightRule>;
+    }
+    if (rule == Rule(SeedsRule())) {
+        return step_row_static<SeedsRule>;
+    }
+    return step_row<DynamicRule>;
+}
 
+/**
+ * step_block_rows(table, rows, upper, lower, x0, x1, width, births, deaths)
+ *
+ * Compute the next generation of columns [x0, x1) of a pair of rows, one 2x2 block of cells at a time.
+ * The 4x4 block around each 2x2 block is gathered into a 16 bit index, one nibble per row,
+ * and the next state of all 4 cells is read from the block table of the rule, see blocktable.cpp.
+ *
+ * When the width is odd the last block hangs one column past the grid. Its right column is computed from
+ * whatever follows the ghost border in the halo buffer, and is not stored.
+ *
+ * @param table
+ *      The block table of the rule, see BlockTable::get_table(rule).
+ *
+ * @param rows
+ *      The row above the pair, the pair itself and the row below, each pointing at column 0 of a padded
+ *      row of the halo buffer. When the lower row of the pair is past the grid, rows[3] may be any readable row.
+ *
+ * @param upper
+ *      The upper row of the pair in the next state grid.
+ *
+ * @param lower
+ *      The lower row of the pair in the next state grid, or nullptr if it is past the bottom of the grid.
+ *
+ * @param x0
+ *      The first column to compute, an even number.
+ *
+ * @param x1
+ *      One past the last column to compute, at most width.
+ *
+ * @param width
+ *      The width of the grid.
+ *
+ * @param births
+ *      Incremented by the number of dead cells which become alive.
+ *
+ * @param deaths
+ *      Incremented by the number of alive cells which become dead.
+ */
+static void step_block_rows(const uint8_t *table, const Cell *const rows[4], Cell *upper, Cell *lower,
+    const unsigned int x0, const unsigned int x1, const unsigned int width,
+    unsigned int &births, unsigned int &deaths) {
+    // Bit 1 tells the two cell values apart, so 4 cells are reduced to a nibble with one mask and one multiply
+    static_assert((Cell::ALIVE & 2) && !(Cell::DEAD & 2), "Cell values must differ in bit 1.");
+    auto nibble = [](const Cell *cells) -> unsigned int {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char*>(cells - 1);
+        const uint32_t packed = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+            (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+        return (((packed >> 1) & 0x01010101u) * 0x01020408u) >> 24;
+    };
+    // Branch free, the table results are too irregular to predict
+    auto to_cell = [](const unsigned int bit) -> Cell {
+        return (Cell)(Cell::DEAD + (bit & 1) * (Cell::ALIVE - Cell::DEAD));
+    };
+    // Number of set bits in a nibble, portable and cheaper than a popcount call where the instruction is missing
+    static const uint64_t BITS[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    // Births in the low 32 bits and deaths in the high 32 bits
+    auto changes = [](const unsigned int before, const unsigned int after) -> uint64_t {
+        return BITS[after & ~before & 0xF] | BITS[before & ~after & 0xF] << 32;
+    };
+    const Cell *row0 = rows[0], *row1 = rows[1], *row2 = rows[2], *row3 = rows[3];
+    uint64_t row_changes = 0;
+    unsigned int x = x0;
+
+    // Whole blocks
+    if (lower != nullptr) {
+        for (; x + 1 < x1; x += 2) {
+            const unsigned int index = nibble(row0 + x) | nibble(row1 + x) << 4 |
+                nibble(row2 + x) << 8 | nibble(row3 + x) << 12;
+            const unsigned int before = ((index >> 5) & 3) | ((index >> 9) & 3) << 2;
+            const unsigned int after = table[index];
+            upper[x] = to_cell(after);
+            upper[x + 1] = to_cell(after >> 1);
+            lower[x] = to_cell(after >> 2);
+            lower[x + 1] = to_cell(after >> 3);
+            row_changes += changes(before, after);
+        }
+    }
+
+    // Blocks hanging past the right or bottom edge of the grid
+    for (; x < x1; x += 2) {
+        const bool pair = x + 1 < width;
+        const unsigned int mask = (pair ? 0xF : 0x5) & (lower != nullptr ? 0xF : 0x3);
+        const unsigned int index = nibble(row0 + x) | nibble(row1 + x) << 4 |
+            nibble(row2 + x) << 8 | nibble(row3 + x) << 12;
+        const unsigned int before = (((index >> 5) & 3) | ((index >> 9) & 3) << 2) & mask;
+        const unsigned int after = table[index] & mask;
+        upper[x] = to_cell(after);
+        if (pair) {
+            upper[x + 1] = to_cell(after >> 1);
+        }
+        if (lower != nullptr) {
+            lower[x] = to_cell(after >> 2);
+            if (pair) {
+                lower[x + 1] = to_cell(after >> 3);
+            }
+        }
+        row_changes += changes(before, after);
+    }
+
+    births += (unsigned int)row_changes;
+    deaths += (unsigned int)(row_changes >> 32);
+}
 
 /**
  * World::step(toroidal)
  *
- * Take one step in Conway's Game of Life.
+ * Take one step in the rule of the world, Conway's Game of Life unless changed with World::set_rule(rule).
  *
  * Reads from the current state grid and writes to the next state grid. Then swaps the grids.
- * Should be implemented by invoking World::count_neighbours(x, y, toroidal).
  * Swapping the grids should be done in O(1) constant time, and should not invoke a copy.
- * Try and boil the logic down to the fewest and most simple conditional statements.
+ *
+ * The current state is mirrored in a halo buffer, padded with a one cell ghost border which holds dead cells,
+ * or copies of the opposite edges when toroidal = true. Only the tiles which changed in the last step are
+ * copied into it, see World::refresh_halo(tile_x, tile_y, toroidal).
+ *
+ * The grid is split into tiles, and only tiles which changed in the last step or border such a tile
+ * are evaluated, see World::find_active_tiles(toroidal). The rows of tiles are split into bands,
+ * one per thread, see World::set_threads(threads).
+ *
+ * The births and deaths counted by the kernel keep the population up to date, see World::get_alive_cells().
+ *
+ * Each row is computed from the rows above and below it in the halo buffer by a vectorized kernel with no
+ * boundary branches, so toroidal and bounded steps cost the same,
+ * see step_row<RULE>(rule, up, row, down, out, x0, x1, births, deaths). With World::Engine::TABLE pairs of rows are
+ * computed 2x2 blocks at a time instead, see step_block_rows(table, rows, upper, lower, x0, x1, width, births, deaths).
  *
  * Rules: https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
  *      - Any live cell with fewer than two live neighbours dies, as if by underpopulation.
@@ -444,35 +984,423 @@ unsigned int World::count_neighbours(const unsigned int x, const unsigned int y,
  *      - Any live cell with more than three live neighbours dies, as if by overpopulation.
  *      - Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
  *
+ * Other Life-like rules replace the counts of two or three and exactly three, see rule.cpp.
+ *
  * @param toroidal
  *      Optional parameter. If true then the step will consider the grid as a torus, where the left edge
  *      wraps to the right edge and the top to the bottom. Defaults to false.
  */
 void World::step(const bool torodial) {
+    // Any step off the HashLife plane leaves it behind the window
+    if (this->extended_rule || this->engine != Engine::HASHLIFE) {
+        this->hashlife.reset();
+    }
+
+    if (this->extended_rule) {
+        this->step_extended(torodial);
+        return;
+    }
+
+    if (this->engine == Engine::BITS || this->engine == Engine::HASHLIFE) {
+        this->advance(1, torodial);
+        return;
+    }
+
+    std::atomic<unsigned int> births(0);
+    std::atomic<unsigned int> deaths(0);
+
+    if (this->engine == Engine::TABLE) {
+        this->block_table = BlockTable::get_table(this->rule);
+    }
+
+    // The ghost border and the set of bordering tiles depend on the topology
+    if (torodial != this->halo_torodial) {
+        this->halo_torodial = torodial;
+        this->mark_all_changed();
+    }
 
-    for (unsigned int y = 0; y < this->get_height(); y++) {
-        for (unsigned int x = 0; x < this->get_height(); x++) {
-            int neighbours = this->count_neighbours(x, y, torodial);
-            if (currGrid(x, y) == Cell::ALIVE) {
-                if (neighbours < 2 || neighbours > 3) {
-                    nextGrid(x, y) = Cell::DEAD;
+    // While looking for a cycle, the tiles this step changes are rehashed as they are computed
+    const bool tracking = this->start_tracking(torodial) && this->period == 0;
+    if (tracking && !this->tile_hash_valid) {
+        this->hash_state();
+    }
+    if (tracking && !this->history_valid) {
+        this->track_generation(this->state_hash);
+    }
+    std::atomic<uint64_t> hash_change(0);
+
+    this->find_active_tiles(torodial);
+    this->for_each_band(this->tiles_y, [&](unsigned int tile_y0, unsigned int tile_y1) {
+        for (unsigned int tile_y = tile_y0; tile_y < tile_y1; tile_y++) {
+            for (unsigned int tile_x = 0; tile_x < this->tiles_x; tile_x++) {
+                if (this->tile_changed[(size_t)tile_y * this->tiles_x + tile_x]) {
+                    this->refresh_halo(tile_x, tile_y, torodial);
                 }
-                else if (neighbours == 2 || neighbours == 3) {
-                    nextGrid(x, y) = Cell::ALIVE;
+            }
+        }
+    });
+    this->for_each_band(this->tiles_y, [&](unsigned int tile_y0, unsigned int tile_y1) {
+        unsigned int band_births = 0;
+        unsigned int band_deaths = 0;
+        uint64_t band_hash_change = 0;
+        for (unsigned int tile_y = tile_y0; tile_y < tile_y1; tile_y++) {
+            for (unsigned int tile_x = 0; tile_x < this->tiles_x; tile_x++) {
+                const size_t tile = (size_t)tile_y * this->tiles_x + tile_x;
+                this->tile_changed[tile] = this->tile_active[tile] &&
+                    this->step_tile(tile_x, tile_y, band_births, band_deaths);
+                if (tracking && this->tile_changed[tile]) {
+                    const uint64_t hash = this->hash_tile(tile_x, tile_y, this->nextGrid);
+                    band_hash_change ^= this->tile_hash[tile] ^ hash;
+                    this->tile_hash[tile] = hash;
                 }
             }
-            else if (neighbours == 3) {
-                nextGrid(x, y) = Cell::ALIVE;
+        }
+        births += band_births;
+        deaths += band_deaths;
+        hash_change ^= band_hash_change;
+    });
+
+    std::swap(currGrid, nextGrid);
+    this->births = births;
+    this->deaths = deaths;
+    this->population += this->births;
+    this->population -= this->deaths;
+
+    this->generation++;
+    if (tracking) {
+        this->state_hash ^= hash_change;
+        this->track_generation(this->state_hash);
+    }
+    else {
+        this->tile_hash_valid = false;
+    }
+}
+
+/**
+ * World::step_extended(toroidal)
+ *
+ * Private helper which takes one step in the Larger than Life rule of the world.
+ *
+ * The current state is padded by R cells on every side, dead when toroidal = false, or wrapped from the opposite
+ * side when toroidal = true (wrapping more than once if R is larger than the grid). A summed-area table of the
+ * padded state is built in two passes, a prefix sum along each row and then down each column. Entry (x, y) holds
+ * the number of alive cells above and left of padded cell (x, y), so the count of any square is 4 reads:
+ *
+ *      count(x, y) = T(x + 2R + 1, y + 2R + 1) - T(x, y + 2R + 1) - T(x + 2R + 1, y) + T(x, y)
+ *
+ * The table is unsigned 32 bit, and the arithmetic is modulo 2^32, so the counts are exact even if the totals
+ * overflow. Every pass is split into bands, one per thread, see World::set_threads(threads).
+ *
+ * The tiles are not used, as a change can spread R cells per step, and are all flagged as changed
+ * when a Life-like rule is set again.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus, where the left edge
+ *      wraps to the right edge and the top to the bottom.
+ */
+void World::step_extended(const bool torodial) {
+    const LargerThanLifeRule &rule = *this->extended_rule;
+    const unsigned int width = this->get_width();
+    const unsigned int height = this->get_height();
+    const unsigned int radius = rule.get_radius();
+    const size_t padded_width = (size_t)width + 2 * radius;
+    const size_t padded_height = (size_t)height + 2 * radius;
+    const size_t stride = padded_width + 1;
+
+    this->births = 0;
+    this->deaths = 0;
+    if (width == 0 || height == 0) {
+        this->generation++;
+        return;
+    }
+
+    const bool tracking = this->start_tracking(torodial) && this->period == 0;
+    if (tracking && !this->history_valid) {
+        this->track_generation(this->hash_state());
+    }
+
+    this->summed_area.resize(stride * (padded_height + 1));
+    uint32_t *table = this->summed_area.data();
+    std::fill(table, table + stride, 0);
+
+    // wrap(c, n) is c modulo n, for c in [-R, n + R)
+    auto wrap = [](const long long c, const unsigned int n) -> unsigned int {
+        const long long m = c % (long long)n;
+        return (unsigned int)(m < 0 ? m + n : m);
+    };
+
+    // Row prefix sums, row py + 1 of the table holds padded row py
+    this->for_each_band((unsigned int)padded_height, [&](unsigned int y0, unsigned int y1) {
+        for (unsigned int py = y0; py < y1; py++) {
+            uint32_t *out = table + (py + 1) * stride;
+            const long long y = (long long)py - radius;
+            if (!torodial && (y < 0 || y >= height)) {
+                std::fill(out, out + stride, 0);
+                continue;
+            }
+            const Cell *cells = this->currGrid.row(wrap(y, height));
+            uint32_t sum = 0;
+            out[0] = 0;
+            for (unsigned int px = 0; px < radius; px++) {
+                sum += torodial && cells[wrap((long long)px - radius, width)] == Cell::ALIVE;
+                out[px + 1] = sum;
+            }
+            for (unsigned int x = 0; x < width; x++) {
+                sum += cells[x] == Cell::ALIVE;
+                out[radius + x + 1] = sum;
             }
-            else {
-                nextGrid(x, y) = Cell::DEAD;
+            for (unsigned int px = 0; px < radius; px++) {
+                sum += torodial && cells[wrap((long long)width + px, width)] == Cell::ALIVE;
+                out[radius + width + px + 1] = sum;
             }
         }
-    }
+    });
+
+    // Column prefix sums, each band walks down its own columns
+    this->for_each_band((unsigned int)stride, [&](unsigned int x0, unsigned int x1) {
+        for (size_t py = 2; py <= padded_height; py++) {
+            uint32_t *row = table + py * stride;
+            const uint32_t *above = row - stride;
+            for (unsigned int x = x0; x < x1; x++) {
+                row[x] += above[x];
+            }
+        }
+    });
+
+    std::atomic<unsigned int> births(0);
+    std::atomic<unsigned int> deaths(0);
+    const unsigned int side = 2 * radius + 1;
+    const uint32_t middle = rule.get_middle() ? 0 : 1;
+    const uint32_t birth_min = rule.get_birth_min();
+    const uint32_t birth_span = rule.get_birth_max() - birth_min;
+    const uint32_t survival_min = rule.get_survival_min();
+    const uint32_t survival_span = rule.get_survival_max() - survival_min;
+    this->for_each_band(height, [&](unsigned int y0, unsigned int y1) {
+        unsigned int band_births = 0;
+        unsigned int band_deaths = 0;
+        for (unsigned int y = y0; y < y1; y++) {
+            const uint32_t *top = table + (size_t)y * stride;
+            const uint32_t *bottom = top + side * stride;
+            const Cell *cells = this->currGrid.row(y);
+            Cell *out = this->nextGrid.row(y);
+            for (unsigned int x = 0; x < width; x++) {
+                const bool alive = cells[x] == Cell::ALIVE;
+                const uint32_t count = bottom[x + side] - bottom[x] - top[x + side] + top[x] - (alive ? middle : 0);
+                // Unsigned range checks, counts below the minimum wrap around to huge values
+                const bool next = alive ? (count - survival_min <= survival_span) : (count - birth_min <= birth_span);
+                out[x] = next ? Cell::ALIVE : Cell::DEAD;
+                band_births += !alive && next;
+                band_deaths += alive && !next;
+            }
+        }
+        births += band_births;
+        deaths += band_deaths;
+    });
 
     std::swap(currGrid, nextGrid);
+    this->births = births;
+    this->deaths = deaths;
+    this->active_tiles = this->tiles_x * this->tiles_y;
+    this->population += this->births;
+    this->population -= this->deaths;
 
-    //std::cout << "Current grid:" << std::endl << currGrid << std::endl << "Prev grid:" << std::endl << nextGrid << std::endl;
+    // Any cell may have changed, so the whole state is rehashed
+    this->generation++;
+    if (tracking) {
+        this->track_generation(this->hash_state());
+    }
+    else {
+        this->tile_hash_valid = false;
+    }
+}
+
+/**
+ * World::mark_all_changed()
+ *
+ * Private helper which sizes the tile flags and the halo buffer to the grid, and flags every tile as changed,
+ * so the next step refreshes the whole halo buffer and evaluates the whole world. Also recounts the population with Grid::get_alive_cells().
+ * Must be called whenever the grids are modified outside of a step.
+ */
+void World::mark_all_changed() {
+    this->tiles_x = (this->get_width() + TILE_SIZE - 1) / TILE_SIZE;
+    this->tiles_y = (this->get_height() + TILE_SIZE - 1) / TILE_SIZE;
+    this->tile_changed.assign((size_t)this->tiles_x * this->tiles_y, 1);
+    this->tile_active.assign((size_t)this->tiles_x * this->tiles_y, 1);
+    // One cell of slack past the last ghost, read by the last block of World::Engine::TABLE when the width is odd
+    this->halo.assign((size_t)(this->get_width() + 2) * (this->get_height() + 2) + 1, Cell::DEAD);
+    this->population = this->currGrid.get_alive_cells();
+    this->births = 0;
+    this->deaths = 0;
+    this->active_tiles = 0;
+    this->tile_hash_valid = false;
+}
+
+/**
+ * World::find_active_tiles(toroidal)
+ *
+ * Private helper which flags the tiles that need evaluating this step: the tiles that changed in the last step,
+ * and the tiles bordering them (wrapping around the edges when toroidal = true).
+ *
+ * Every other tile is guaranteed to keep its contents. Its cells are also already in the next state grid,
+ * because it was unchanged between the generation held there and the current one, so it can be skipped entirely.
+ *
+ * @param toroidal
+ *      If true then tiles on opposite edges of the grid border each other.
+ */
+void World::find_active_tiles(const bool torodial) {
+    std::fill(this->tile_active.begin(), this->tile_active.end(), 0);
+    this->active_tiles = 0;
+    for (unsigned int tile_y = 0; tile_y < this->tiles_y; tile_y++) {
+        for (unsigned int tile_x = 0; tile_x < this->tiles_x; tile_x++) {
+            if (!this->tile_changed[(size_t)tile_y * this->tiles_x + tile_x]) {
+                continue;
+            }
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    long long x = (long long)tile_x + dx;
+                    long long y = (long long)tile_y + dy;
+                    if (torodial) {
+                        x = (x + this->tiles_x) % this->tiles_x;
+                        y = (y + this->tiles_y) % this->tiles_y;
+                    }
+                    else if (x < 0 || y < 0 || x >= this->tiles_x || y >= this->tiles_y) {
+                        continue;
+                    }
+                    unsigned char &active = this->tile_active[(size_t)y * this->tiles_x + x];
+                    this->active_tiles += !active;
+                    active = 1;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * World::step_tile(tile_x, tile_y, births, deaths)
+ *
+ * Private helper which computes one tile of the next state grid from the halo buffer.
+ * The ghost border of the halo buffer already encodes the topology, so the kernel is the same for both.
+ * Only the cells of this tile in the next state grid are written, so different tiles can run on different threads.
+ *
+ * @param tile_x
+ *      The column of the tile.
+ *
+ * @param tile_y
+ *      The row of the tile.
+ *
+ * @param births
+ *      Incremented by the number of cells of the tile which become alive.
+ *
+ * @param deaths
+ *      Incremented by the number of cells of the tile which become dead.
+ *
+ * @return
+ *      True if any cell of the tile changed.
+ */
+bool World::step_tile(const unsigned int tile_x, const unsigned int tile_y,
+    unsigned int &births, unsigned int &deaths) {
+    const unsigned int width = this->get_width();
+    const unsigned int stride = width + 2;
+    const unsigned int x0 = tile_x * TILE_SIZE;
+    const unsigned int x1 = std::min(width, x0 + TILE_SIZE);
+    const unsigned int y0 = tile_y * TILE_SIZE;
+    const unsigned int y1 = std::min(this->get_height(), y0 + TILE_SIZE);
+    const Cell *padded = this->halo.data() + 1;
+    Cell *next = this->nextGrid.data();
+    unsigned int tile_births = 0;
+    unsigned int tile_deaths = 0;
+
+    if (this->engine == Engine::TABLE) {
+        // Tiles start on even rows and columns, so the 2x2 blocks never straddle two tiles
+        for (unsigned int y = y0; y < y1; y += 2) {
+            const Cell *up = padded + (size_t)y * stride;
+            const bool pair = y + 1 < y1;
+            const Cell *const rows[4] = {up, up + stride, up + 2 * stride, pair ? up + 3 * stride : up};
+            step_block_rows(this->block_table, rows, next + (size_t)y * width, pair ? next + (size_t)(y + 1) * width : nullptr,
+                x0, x1, width, tile_births, tile_deaths);
+        }
+    }
+    else {
+        const RowKernel kernel = select_row_kernel(this->rule);
+        const DynamicRule rule{this->rule.get_birth(), this->rule.get_survival()};
+        for (unsigned int y = y0; y < y1; y++) {
+            // Row y of the grid is row y + 1 of the halo buffer
+            const Cell *up = padded + (size_t)y * stride;
+            kernel(rule, up, up + stride, up + 2 * stride, next + (size_t)y * width, x0, x1, tile_births, tile_deaths);
+        }
+    }
+
+    births += tile_births;
+    deaths += tile_deaths;
+    return tile_births != 0 || tile_deaths != 0;
+}
+
+/**
+ * World::refresh_halo(tile_x, tile_y, toroidal)
+ *
+ * Private helper which copies one tile of the current state grid into the interior of the halo buffer.
+ * When toroidal = true the cells of the tile on the edges of the grid are also copied into the ghost border
+ * on the opposite side, so reading one cell past any edge wraps around. Otherwise the ghost border stays dead.
+ *
+ * Every cell of the halo buffer is written by exactly one tile, so different tiles can run on different threads.
+ *
+ * @param tile_x
+ *      The column of the tile.
+ *
+ * @param tile_y
+ *      The row of the tile.
+ *
+ * @param toroidal
+ *      If true then the ghost border wraps around to the opposite edges.
+ */
+void World::refresh_halo(const unsigned int tile_x, const unsigned int tile_y, const bool torodial) {
+    const unsigned int width = this->get_width();
+    const unsigned int height = this->get_height();
+    const size_t stride = width + 2;
+    const unsigned int x0 = tile_x * TILE_SIZE;
+    const unsigned int x1 = std::min(width, x0 + TILE_SIZE);
+    const unsigned int y0 = tile_y * TILE_SIZE;
+    const unsigned int y1 = std::min(height, y0 + TILE_SIZE);
+    const Cell *cells = this->currGrid.data();
+    Cell *halo = this->halo.data();
+
+    // halo_at(x, y) is the halo buffer cell for grid coordinate (x, y), where x and y may be -1 or one past the end
+    auto halo_at = [&](const long long x, const long long y) -> Cell& {
+        return halo[(size_t)(y + 1) * stride + (size_t)(x + 1)];
+    };
+
+    for (unsigned int y = y0; y < y1; y++) {
+        const Cell *row = cells + (size_t)y * width;
+        std::copy(row + x0, row + x1, &halo_at(x0, y));
+        if (!torodial) {
+            continue;
+        }
+
+        if (x0 == 0) {
+            halo_at(width, y) = row[0];
+        }
+        if (x1 == width) {
+            halo_at(-1, y) = row[width - 1];
+        }
+        if (y == 0) {
+            std::copy(row + x0, row + x1, &halo_at(x0, height));
+            if (x0 == 0) {
+                halo_at(width, height) = row[0];
+            }
+            if (x1 == width) {
+                halo_at(-1, height) = row[width - 1];
+            }
+        }
+        if (y == height - 1) {
+            std::copy(row + x0, row + x1, &halo_at(x0, -1));
+            if (x0 == 0) {
+                halo_at(width, -1) = row[0];
+            }
+            if (x1 == width) {
+                halo_at(-1, -1) = row[width - 1];
+            }
+        }
+    }
 }
 
 
@@ -480,7 +1408,16 @@ void World::step(const bool torodial) {
  * World::advance(steps, toroidal)
  *
  * Advance multiple steps in the Game of Life.
- * Should be implemented by invoking World::step(toroidal).
+ * With World::Engine::CELLS and World::Engine::TABLE this is implemented by invoking World::step(toroidal).
+ * With a Larger than Life rule every engine is implemented by invoking World::step(toroidal).
+ * With World::Engine::BITS the state is packed once, stepped with BitGrid::step(next, toroidal), and unpacked once.
+ * With World::Engine::HASHLIFE the state is loaded into HashLife on the first call, advanced with
+ * HashLife::advance(steps), and the window covered by the world is copied back. The plane is kept for the next
+ * call, so cells outside the window carry on evolving and may come back into it, see World::set_engine(engine).
+ *
+ * With cycle detection on, see World::set_cycle_detection(max_period), once the world is found to repeat with
+ * period p the remaining steps are reduced modulo p: whole cycles are skipped and only the part cycle left
+ * is stepped. A world which has died out or frozen has period 1, so advancing it returns at once.
  *
  * @param steps
  *      The number of steps to advance the world forward.
@@ -488,9 +1425,330 @@ void World::step(const bool torodial) {
  * @param toroidal
  *      Optional parameter. If true then the step will consider the grid as a torus, where the left edge
  *      wraps to the right edge and the top to the bottom. Defaults to false.
+ *
+ * @throws
+ *      std::invalid_argument if toroidal = true with World::Engine::HASHLIFE,
+ *      or if the rule gives birth on 0 neighbours with World::Engine::HASHLIFE.
  */
-void World::advance(const unsigned int steps, const bool torodial) {
-    for (unsigned int i = 0; i < steps; i++) {
+void World::advance(const unsigned long long steps, const bool torodial) {
+    // A change of topology invalidates a cycle found before it
+    const bool tracking = this->start_tracking(torodial);
+
+    if (!this->extended_rule && this->engine == Engine::HASHLIFE) {
+        if (torodial) {
+            throw std::invalid_argument("advance() : The HashLife engine does not support a toroidal world.");
+        }
+        // Copies of a world share its plane, so whichever advances first starts a plane of its own from its window
+        if (!this->hashlife || this->hashlife.use_count() > 1) {
+            this->hashlife = std::make_shared<HashLife>(this->currGrid, this->rule);
+        }
+        this->hashlife->advance(steps);
+        this->currGrid = this->hashlife->to_grid(0, 0, this->get_width(), this->get_height());
+        this->mark_all_changed();
+        // The generations in between are never seen, so cycles cannot be followed across the jump
+        this->generation += steps;
+        this->reset_cycle();
+        return;
+    }
+
+    this->hashlife.reset();
+    if (!this->extended_rule && this->engine == Engine::BITS) {
+        unsigned long long left = this->skip_cycles(steps);
+        if (left == 0) {
+            return;
+        }
+        BitGrid bits(this->currGrid);
+        BitGrid scratch(bits.get_width(), bits.get_height());
+        if (tracking && this->period == 0 && !this->history_valid) {
+            this->track_generation(this->hash_bits(bits));
+        }
+        while (left > 0) {
+            this->for_each_band(bits.get_height(), [&](unsigned int y0, unsigned int y1) {
+                bits.step_rows(scratch, y0, y1, torodial, this->rule);
+            });
+            std::swap(bits, scratch);
+            this->generation++;
+            left--;
+            if (tracking && this->period == 0) {
+                this->track_generation(this->hash_bits(bits));
+                left = this->skip_cycles(left);
+            }
+        }
+        this->currGrid = bits.to_grid();
+        this->mark_all_changed();
+        return;
+    }
+
+    // The births and deaths are summed over the steps, so a call reports all of them
+    unsigned long long left = this->skip_cycles(steps);
+    unsigned int births = 0, deaths = 0;
+    while (left > 0) {
         this->step(torodial);
+        births += this->births;
+        deaths += this->deaths;
+        left = this->skip_cycles(left - 1);
+    }
+    this->births = births;
+    this->deaths = deaths;
+}
+
+/**
+ * World::get_cycle_detection()
+ *
+ * Gets the longest period of cycle the world looks for.
+ *
+ * @return
+ *      The longest period detected, or 0 if cycle detection is off, which it is unless changed with
+ *      World::set_cycle_detection(max_period).
+ */
+unsigned int World::get_cycle_detection() const {
+    return this->max_period;
+}
+
+/**
+ * World::set_cycle_detection(max_period)
+ *
+ * Turns on detection of cycles of up to max_period generations, or turns it off with max_period = 0.
+ *
+ * Each generation stepped is hashed, and the hashes of the last max_period generations are kept. A generation
+ * whose hash matches one p generations before it has entered a cycle of period p: p = 1 for a world which has
+ * died out or frozen into still lifes, p = 2 for blinkers, and so on. From then on World::advance(steps, toroidal)
+ * skips whole cycles, see World::get_period() and World::get_phase().
+ *
+ * The hash of the state is the XOR of a hash of each tile, which is position dependent, and World::step(toroidal)
+ * rehashes only the tiles it changed, so looking for cycles costs little more than the step itself.
+ * A cycle found is forgotten when the state, the rule or the topology changes outside of a step.
+ * World::Engine::HASHLIFE jumps over the generations in between, so it does not detect cycles.
+ *
+ * @example
+ *
+ *      // Make a world from a soup
+ *      World world(soup);
+ *
+ *      // Look for cycles of up to 64 generations, then run it for a million generations
+ *      world.set_cycle_detection(64);
+ *      world.advance(1000000);
+ *
+ *      // Most soups have settled into still lifes and oscillators long before the end
+ *      std::cout << "Period " << world.get_period() << std::endl;
+ *
+ * @param max_period
+ *      The longest period to detect, each generation is compared against this many earlier ones.
+ */
+void World::set_cycle_detection(const unsigned int max_period) {
+    this->max_period = max_period;
+    this->recent_hashes.assign(max_period, 0);
+    this->reset_cycle();
+}
+
+/**
+ * World::get_period()
+ *
+ * Gets the period of the cycle the world has been found to be in.
+ *
+ * @return
+ *      The period, 1 for a world which has died out or frozen, or 0 if no cycle has been found.
+ */
+unsigned int World::get_period() const {
+    return this->period;
+}
+
+/**
+ * World::get_phase()
+ *
+ * Gets where the current generation is in the cycle the world has been found to be in.
+ * Phase 0 is the first generation seen to repeat, so two worlds in the same cycle at the same phase
+ * hold the same state.
+ *
+ * @return
+ *      The phase, from 0 to World::get_period() - 1, or 0 if no cycle has been found.
+ */
+unsigned long long World::get_phase() const {
+    if (this->period == 0) {
+        return 0;
     }
-}
\ No newline at end of file
+    return (this->generation - this->cycle_start) % this->period;
+}
+
+/**
+ * hash_word(hash, word)
+ *
+ * Mix one 64 bit word into the running hash of a tile, a rotate and a multiply so each row costs one multiply.
+ */
+static inline uint64_t hash_word(const uint64_t hash, const uint64_t word) {
+    const uint64_t mixed = hash ^ word;
+    return ((mixed << 23) | (mixed >> 41)) * 0x9e3779b97f4a7c15ULL;
+}
+
+/**
+ * hash_finish(hash)
+ *
+ * Finish the hash of a tile with the finalizer of splitmix64, so every bit of every row affects every bit
+ * of the result, and the XOR of the hashes of many tiles stays well mixed.
+ */
+static inline uint64_t hash_finish(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/**
+ * World::hash_tile(tile_x, tile_y, grid)
+ *
+ * Private helper which hashes one tile of a grid the size of the world.
+ * Each row of the tile is packed into a word, see BitGrid::pack(cells, count), and mixed into a hash seeded
+ * by the position of the tile, so equal tiles in different places hash differently.
+ * A tile with no alive cells hashes to 0. World::hash_bits(bits) gives the same hashes for a BitGrid.
+ *
+ * @return
+ *      The hash of the tile.
+ */
+uint64_t World::hash_tile(const unsigned int tile_x, const unsigned int tile_y, const Grid &grid) const {
+    const unsigned int x0 = tile_x * TILE_SIZE;
+    const unsigned int x1 = std::min(this->get_width(), x0 + TILE_SIZE);
+    const unsigned int y0 = tile_y * TILE_SIZE;
+    const unsigned int y1 = std::min(this->get_height(), y0 + TILE_SIZE);
+    uint64_t hash = hash_finish((uint64_t)tile_y * this->tiles_x + tile_x + 1);
+    uint64_t alive = 0;
+    for (unsigned int y = y0; y < y1; y++) {
+        const uint64_t word = BitGrid::pack(grid.row(y) + x0, x1 - x0);
+        hash = hash_word(hash, word);
+        alive |= word;
+    }
+    return alive ? hash_finish(hash) : 0;
+}
+
+/**
+ * World::hash_state()
+ *
+ * Private helper which rehashes every tile of the current state, in bands on the thread pool,
+ * and combines them into the hash of the state.
+ *
+ * @return
+ *      The hash of the current state.
+ */
+uint64_t World::hash_state() {
+    this->tile_hash.resize((size_t)this->tiles_x * this->tiles_y);
+    std::atomic<uint64_t> state_hash(0);
+    this->for_each_band(this->tiles_y, [&](unsigned int tile_y0, unsigned int tile_y1) {
+        uint64_t band_hash = 0;
+        for (unsigned int tile_y = tile_y0; tile_y < tile_y1; tile_y++) {
+            for (unsigned int tile_x = 0; tile_x < this->tiles_x; tile_x++) {
+                const uint64_t hash = this->hash_tile(tile_x, tile_y, this->currGrid);
+                this->tile_hash[(size_t)tile_y * this->tiles_x + tile_x] = hash;
+                band_hash ^= hash;
+            }
+        }
+        state_hash ^= band_hash;
+    });
+    this->state_hash = state_hash;
+    this->tile_hash_valid = true;
+    return this->state_hash;
+}
+
+/**
+ * World::hash_bits(bits)
+ *
+ * Private helper which hashes a BitGrid the size of the world, giving the same hash as World::hash_state()
+ * would for the same cells. A tile is one 64 bit word wide, so its rows are read straight from the BitGrid.
+ *
+ * @return
+ *      The hash of the cells.
+ */
+uint64_t World::hash_bits(const BitGrid &bits) const {
+    uint64_t state_hash = 0;
+    for (unsigned int tile_y = 0; tile_y < this->tiles_y; tile_y++) {
+        const unsigned int y0 = tile_y * TILE_SIZE;
+        const unsigned int y1 = std::min(this->get_height(), y0 + TILE_SIZE);
+        for (unsigned int tile_x = 0; tile_x < this->tiles_x; tile_x++) {
+            uint64_t hash = hash_finish((uint64_t)tile_y * this->tiles_x + tile_x + 1);
+            uint64_t alive = 0;
+            for (unsigned int y = y0; y < y1; y++) {
+                const uint64_t word = bits.row(y)[tile_x];
+                hash = hash_word(hash, word);
+                alive |= word;
+            }
+            state_hash ^= alive ? hash_finish(hash) : 0;
+        }
+    }
+    return state_hash;
+}
+
+/**
+ * World::start_tracking(toroidal)
+ *
+ * Private helper called before stepping, which forgets any cycle found under the other topology.
+ *
+ * @return
+ *      True if cycle detection is on.
+ */
+bool World::start_tracking(const bool torodial) {
+    if (this->max_period == 0) {
+        return false;
+    }
+    if (torodial != this->cycle_torodial) {
+        this->cycle_torodial = torodial;
+        this->reset_cycle();
+    }
+    return true;
+}
+
+/**
+ * World::track_generation(hash)
+ *
+ * Private helper which records the hash of the current generation, and compares it with the hashes of
+ * up to max_period generations before it. The closest match gives the period of the cycle.
+ *
+ * @param hash
+ *      The hash of the current state.
+ */
+void World::track_generation(const uint64_t hash) {
+    if (!this->history_valid) {
+        this->history_valid = true;
+        this->history_start = this->generation;
+    }
+    const unsigned long long recorded = std::min<unsigned long long>(this->generation - this->history_start,
+                                                                     this->max_period);
+    for (unsigned int p = 1; p <= recorded; p++) {
+        if (this->recent_hashes[(this->generation - p) % this->max_period] == hash) {
+            this->period = p;
+            this->cycle_start = this->generation - p;
+            break;
+        }
+    }
+    this->recent_hashes[this->generation % this->max_period] = hash;
+}
+
+/**
+ * World::reset_cycle()
+ *
+ * Private helper which forgets the generations recorded and any cycle found.
+ * Must be called whenever the state, the rule or the topology changes outside of a step.
+ */
+void World::reset_cycle() {
+    this->history_valid = false;
+    this->period = 0;
+    this->cycle_start = 0;
+}
+
+/**
+ * World::skip_cycles(steps)
+ *
+ * Private helper which skips every whole cycle in a number of steps, if a cycle has been found.
+ *
+ * @param steps
+ *      The number of steps left to take.
+ *
+ * @return
+ *      The number of steps still to take, less than the period if a cycle has been found.
+ */
+unsigned long long World::skip_cycles(const unsigned long long steps) {
+    if (this->period == 0) {
+        return steps;
+    }
+    this->generation += steps - steps % this->period;
+    return steps % this->period;
+}
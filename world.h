@@ -10,40 +10,146 @@
  */
 #pragma once
 #include "grid.h"
+#include "rule.h"
+#include "larger_than_life.h"
+#include "threadpool.h"
+#include <memory>
+#include <vector>
+#include <optional>
 
 // Add the minimal number of includes you need in order to declare the class.
 // #include ...
 
+class BitGrid;
+class HashLife;
+
 /**
  * Declare the structure of the World class for representing a 2d grid world.
  *
  * A World holds two equally sized Grid objects for the current state and next state.
  *      - These buffers should be swapped using std::swap after each update step.
+ *
+ * A World can share a ThreadPool between its copies, which splits each step into row bands.
+ *
+ * A World tracks which tiles of the grid changed in the last step, so quiescent regions are not re-evaluated.
+ *
+ * A World steps either a Life-like Rule over the 3x3 neighbourhood, or a LargerThanLifeRule over a radius R
+ * neighbourhood using a summed-area table.
+ *
+ * A World can hash each generation and detect when it repeats, so advancing a world which has died out, frozen
+ * or started to oscillate skips the whole cycles it has left to go round.
  */
 class World {
+    public:
+        /**
+         * The algorithm used to step the world forward.
+         *      - CELLS steps the Grid state directly, one cell at a time.
+         *      - BITS packs the state into a BitGrid and steps 64 cells at a time.
+         *      - TABLE steps the Grid state directly, one 2x2 block at a time with a precomputed lookup table.
+         *      - HASHLIFE advances the state on the unbounded plane with HashLife, jumping many generations at once.
+         */
+        enum class Engine {
+            CELLS,
+            BITS,
+            TABLE,
+            HASHLIFE
+        };
+
     private:
         Grid currGrid;
         Grid nextGrid;
+        Engine engine;
+        Rule rule;
+        std::optional<LargerThanLifeRule> extended_rule;
+        std::shared_ptr<ThreadPool> pool;
+
+        // The plane simulated by World::Engine::HASHLIFE, kept between calls to World::advance(steps, toroidal) so
+        // cells which leave the window are not lost. Dropped whenever the state is changed any other way.
+        std::shared_ptr<HashLife> hashlife;
+
+        // The world is split into TILE_SIZE x TILE_SIZE tiles, each flagged if it changed in the last step.
+        static const unsigned int TILE_SIZE = 64;
+        unsigned int tiles_x;
+        unsigned int tiles_y;
+        std::vector<unsigned char> tile_changed;
+        std::vector<unsigned char> tile_active;
+        unsigned int active_tiles;
+
+        // A copy of the current state padded with a one cell ghost border, see World::refresh_halo.
+        std::vector<Cell> halo;
+        bool halo_torodial;
+
+        // The block table of the rule, fetched at the start of each World::Engine::TABLE step.
+        const uint8_t *block_table;
+
+        // The summed-area table of the current state, rebuilt by each Larger than Life step.
+        std::vector<uint32_t> summed_area;
+
+        // The population is kept up to date by each step, from the births and deaths it counts.
+        unsigned int population;
+        unsigned int births;
+        unsigned int deaths;
+
+        // Cycle detection, see World::set_cycle_detection(max_period). The hash of the state is the XOR of the
+        // hashes of its tiles, so a step only rehashes the tiles it changed.
+        unsigned long long generation;
+        unsigned int max_period;
+        std::vector<uint64_t> tile_hash;
+        bool tile_hash_valid;
+        uint64_t state_hash;
+        std::vector<uint64_t> recent_hashes;
+        bool history_valid;
+        unsigned long long history_start;
+        bool cycle_torodial;
+        unsigned int period;
+        unsigned long long cycle_start;
 
-        unsigned int count_neighbours(const unsigned int x, const unsigned int y, 
-            const bool torodial) const;
+        void mark_all_changed();
+        void find_active_tiles(const bool torodial);
+        void refresh_halo(const unsigned int tile_x, const unsigned int tile_y, const bool torodial);
+        bool step_tile(const unsigned int tile_x, const unsigned int tile_y,
+            unsigned int &births, unsigned int &deaths);
+        void step_extended(const bool torodial);
+        void for_each_band(const unsigned int count, const std::function<void(unsigned int, unsigned int)> &band);
+        uint64_t hash_tile(const unsigned int tile_x, const unsigned int tile_y, const Grid &grid) const;
+        uint64_t hash_state();
+        uint64_t hash_bits(const BitGrid &bits) const;
+        bool start_tracking(const bool torodial);
+        void track_generation(const uint64_t hash);
+        void reset_cycle();
+        unsigned long long skip_cycles(const unsigned long long steps);
 
     public:
         World();
         World(const unsigned int square_size);
         World(const unsigned int width, const unsigned int height);
-        World(const const Grid initial_state);
+        World(const Grid initial_state);
 
         unsigned int get_width() const;
         unsigned int get_height() const;
         unsigned int get_total_cells() const;
         unsigned int get_alive_cells() const;
         unsigned int get_dead_cells() const;
+        unsigned int get_births() const;
+        unsigned int get_deaths() const;
+        unsigned int get_active_tiles() const;
         const Grid& get_state() const;
+        Engine get_engine() const;
+        void set_engine(const Engine engine);
+        Rule get_rule() const;
+        void set_rule(const Rule &rule);
+        const LargerThanLifeRule* get_extended_rule() const;
+        void set_rule(const LargerThanLifeRule &rule);
+        unsigned int get_threads() const;
+        void set_threads(const unsigned int threads);
         void resize(const unsigned int square_size);
         void resize(const unsigned int new_width, const unsigned int new_height);
         void step(const bool torodial = false);
-        void advance(const unsigned int steps, const bool torodial = false);
+        void advance(const unsigned long long steps, const bool torodial = false);
+        unsigned int get_cycle_detection() const;
+        void set_cycle_detection(const unsigned int max_period);
+        unsigned int get_period() const;
+        unsigned long long get_phase() const;
 
 
 };
\ No newline at end of file
@@ -0,0 +1,719 @@
+/**
+ * Implements a class representing a batch of small, equally sized, independent worlds.
+ *      - Worlds are stepped 64 cells per word with the logic of bitlogic.h. Worlds up to 64 cells wide, one word
+ *        per row, use a kernel of plain shifts, wider worlds the kernel of BitGrid, see BitGrid::step_words.
+ *      - Each world is advanced through all of its steps before the next one is touched, so a small world
+ *        stays in the L1 cache of its thread for the whole call.
+ *      - Worlds are handed to threads in chunks, so threads which get quickly terminating worlds take more chunks.
+ *      - A world can be filled with a reproducible random soup, seeded only by its soup number, so the result of
+ *        a search does not depend on the batch size or the number of threads.
+ */
+#include "world_batch.h"
+#include "bitgrid.h"
+#include "bitlogic.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+// The worlds handed to a thread at a time.
+static const unsigned int CHUNK_SIZE = 64;
+
+/**
+ * WorldBatch::WorldBatch()
+ *
+ * Construct an empty batch of no worlds.
+ *
+ * @example
+ *
+ *      // Make an empty batch
+ *      WorldBatch batch;
+ *
+ */
+WorldBatch::WorldBatch() : WorldBatch(0, 0) {
+}
+
+/**
+ * WorldBatch::WorldBatch(count, square_size)
+ *
+ * Construct a batch of square worlds filled with dead cells.
+ *
+ * @example
+ *
+ *      // Make 10000 32x32 worlds
+ *      WorldBatch batch(10000, 32);
+ *
+ * @param count
+ *      The number of worlds.
+ *
+ * @param square_size
+ *      The edge size to use for the width and height of every world.
+ */
+WorldBatch::WorldBatch(const unsigned int count, const unsigned int square_size)
+    : WorldBatch(count, square_size, square_size) {
+}
+
+/**
+ * WorldBatch::WorldBatch(count, width, height)
+ *
+ * Construct a batch of worlds filled with dead cells, all allocated at once.
+ * The worlds step Conway's Game of Life on one thread with cycle detection off, until changed.
+ *
+ * @example
+ *
+ *      // Make 10000 64x16 worlds
+ *      WorldBatch batch(10000, 64, 16);
+ *
+ * @param count
+ *      The number of worlds.
+ *
+ * @param width
+ *      The width of every world.
+ *
+ * @param height
+ *      The height of every world.
+ */
+WorldBatch::WorldBatch(const unsigned int count, const unsigned int width, const unsigned int height)
+    : count(count), width(width), height(height), words_per_world(((width + 63) / 64) * height),
+      words((size_t)count * (((width + 63) / 64) * height), 0), populations(count, 0), generations(count, 0),
+      periods(count, 0), max_period(0), history_sizes(count, 0) {
+}
+
+/**
+ * WorldBatch::get_count()
+ *
+ * Gets the number of worlds in the batch.
+ *
+ * @return
+ *      The number of worlds.
+ */
+unsigned int WorldBatch::get_count() const {
+    return this->count;
+}
+
+/**
+ * WorldBatch::get_width()
+ *
+ * Gets the width of every world in the batch.
+ *
+ * @return
+ *      The width in cells.
+ */
+unsigned int WorldBatch::get_width() const {
+    return this->width;
+}
+
+/**
+ * WorldBatch::get_height()
+ *
+ * Gets the height of every world in the batch.
+ *
+ * @return
+ *      The height in cells.
+ */
+unsigned int WorldBatch::get_height() const {
+    return this->height;
+}
+
+/**
+ * WorldBatch::get_state(index)
+ *
+ * Gets the current state of one world, unpacked into a Grid.
+ *
+ * @example
+ *
+ *      // Print the first world of a batch
+ *      std::cout << batch.get_state(0) << std::endl;
+ *
+ * @param index
+ *      The index of the world.
+ *
+ * @return
+ *      A grid of the size of the world.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not in the batch.
+ */
+Grid WorldBatch::get_state(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("get_state() : Invalid index.");
+    }
+    const unsigned int words_per_row = (this->width + 63) / 64;
+    const uint64_t *world = this->words.data() + (size_t)index * this->words_per_world;
+    Grid grid(this->width, this->height);
+    for (unsigned int y = 0; y < this->height; y++) {
+        const uint64_t *row = world + (size_t)y * words_per_row;
+        Cell *cells = grid.row(y);
+        for (unsigned int x = 0; x < this->width; x++) {
+            if ((row[x / 64] >> (x % 64)) & 1) {
+                cells[x] = Cell::ALIVE;
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * WorldBatch::set_state(index, grid)
+ *
+ * Replace the state of one world, which starts again from generation 0 with no cycle found.
+ *
+ * @example
+ *
+ *      // Put a glider in the corner of the first world of a batch
+ *      Grid grid(batch.get_width(), batch.get_height());
+ *      grid.merge(Zoo::glider(), 0, 0);
+ *      batch.set_state(0, grid);
+ *
+ * @param index
+ *      The index of the world.
+ *
+ * @param grid
+ *      The new state, which must be the size of the worlds.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not in the batch or the grid is the wrong size.
+ */
+void WorldBatch::set_state(const unsigned int index, const Grid &grid) {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("set_state() : Invalid index.");
+    }
+    if (grid.get_width() != this->width || grid.get_height() != this->height) {
+        throw std::invalid_argument("set_state() : Grid is not the size of the worlds.");
+    }
+    const unsigned int words_per_row = (this->width + 63) / 64;
+    uint64_t *world = this->words.data() + (size_t)index * this->words_per_world;
+    unsigned int population = 0;
+    for (unsigned int y = 0; y < this->height; y++) {
+        uint64_t *row = world + (size_t)y * words_per_row;
+        const Cell *cells = grid.row(y);
+        for (unsigned int x = 0; x < this->width; x += 64) {
+            row[x / 64] = BitGrid::pack(cells + x, std::min(64u, this->width - x));
+            population += __builtin_popcountll(row[x / 64]);
+        }
+    }
+    this->reset_world(index);
+    this->populations[index] = population;
+}
+
+/**
+ * soup_random(state)
+ *
+ * The splitmix64 generator, advancing its state and returning the next 64 random bits.
+ */
+static inline uint64_t soup_random(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * WorldBatch::randomize(seed, first, density)
+ *
+ * Fill every world with a random soup, world i with soup number first + i. Each soup depends only on the seed,
+ * its soup number, the density and the size of the worlds, so a soup can be recreated in a batch of any size
+ * on any number of threads. Every world starts again from generation 0 with no cycle found.
+ *
+ * @example
+ *
+ *      // Search soups 0 to 9999 of seed 42, then soups 10000 to 19999
+ *      WorldBatch batch(10000, 16);
+ *      batch.randomize(42, 0);
+ *      batch.advance(1000);
+ *      batch.randomize(42, 10000);
+ *      batch.advance(1000);
+ *
+ * @param seed
+ *      The seed of the search.
+ *
+ * @param first
+ *      The soup number of the first world.
+ *
+ * @param density
+ *      Optional parameter. The probability of each cell being alive, defaults to 0.5.
+ */
+void WorldBatch::randomize(const uint64_t seed, const unsigned long long first, const double density) {
+    this->randomize(seed, first, density, 0, 0, this->width, this->height);
+}
+
+/**
+ * WorldBatch::randomize(seed, first, density, x0, y0, x1, y1)
+ *
+ * Fill a window [x0, x1) x [y0, y1) of every world with a random soup and the rest with dead cells,
+ * world i with soup number first + i. Each soup depends only on the seed, its soup number, the density and
+ * the size of the window, wherever the window is and whatever the size of the worlds.
+ * Every world starts again from generation 0 with no cycle found.
+ *
+ * @example
+ *
+ *      // Put 16x16 soups in the middle of 64x64 worlds
+ *      WorldBatch batch(10000, 64);
+ *      batch.randomize(42, 0, 0.5, 24, 24, 40, 40);
+ *
+ * @param seed
+ *      The seed of the search.
+ *
+ * @param first
+ *      The soup number of the first world.
+ *
+ * @param density
+ *      The probability of each cell being alive.
+ *
+ * @param x0
+ *      The left edge of the window.
+ *
+ * @param y0
+ *      The top edge of the window.
+ *
+ * @param x1
+ *      One past the right edge of the window.
+ *
+ * @param y1
+ *      One past the bottom edge of the window.
+ *
+ * @throws
+ *      std::invalid_argument if the window is not inside the worlds.
+ */
+void WorldBatch::randomize(const uint64_t seed, const unsigned long long first, const double density,
+    const unsigned int x0, const unsigned int y0, const unsigned int x1, const unsigned int y1) {
+    if (x0 > x1 || y0 > y1 || x1 > this->width || y1 > this->height) {
+        throw std::invalid_argument("randomize() : Invalid coordinates.");
+    }
+    const unsigned int words_per_row = (this->width + 63) / 64;
+    const unsigned int soup_width = x1 - x0;
+    const uint64_t threshold = (uint64_t)(std::min(std::max(density, 0.0), 1.0) * 4294967296.0);
+    const bool half = density == 0.5;
+
+    this->for_each_world([&](unsigned int i0, unsigned int i1) {
+        for (unsigned int i = i0; i < i1; i++) {
+            uint64_t state = seed;
+            state = soup_random(state) ^ (first + i);
+            soup_random(state);
+            uint64_t *world = this->words.data() + (size_t)i * this->words_per_world;
+            std::fill(world, world + this->words_per_world, 0);
+            unsigned int population = 0;
+            for (unsigned int y = y0; y < y1; y++) {
+                uint64_t *row = world + (size_t)y * words_per_row;
+                // The soup is generated 64 cells at a time, then shifted to its place in the row
+                for (unsigned int sx = 0; sx < soup_width; sx += 64) {
+                    const unsigned int cells = std::min(64u, soup_width - sx);
+                    uint64_t word = 0;
+                    if (half) {
+                        word = soup_random(state);
+                    }
+                    else {
+                        // Two cells from each 64 random bits
+                        for (unsigned int x = 0; x < cells; x += 2) {
+                            const uint64_t random = soup_random(state);
+                            word |= (uint64_t)((random & 0xFFFFFFFFULL) < threshold) << x;
+                            word |= (uint64_t)((random >> 32) < threshold) << (x + 1);
+                        }
+                    }
+                    if (cells < 64) {
+                        word &= ((uint64_t)1 << cells) - 1;
+                    }
+                    const unsigned int x = x0 + sx;
+                    row[x / 64] |= word << (x % 64);
+                    if (x % 64 != 0 && x % 64 + cells > 64) {
+                        row[x / 64 + 1] |= word >> (64 - x % 64);
+                    }
+                    population += __builtin_popcountll(word);
+                }
+            }
+            this->reset_world(i);
+            this->populations[i] = population;
+        }
+    });
+}
+
+/**
+ * WorldBatch::get_rule()
+ *
+ * Gets the Life-like rule every world is stepped with.
+ *
+ * @return
+ *      The rule, B3/S23 unless changed with WorldBatch::set_rule(rule).
+ */
+Rule WorldBatch::get_rule() const {
+    return this->rule;
+}
+
+/**
+ * WorldBatch::set_rule(rule)
+ *
+ * Selects the Life-like rule every world is stepped with. A cycle found under the old rule is forgotten.
+ *
+ * @param rule
+ *      The rule to step with.
+ */
+void WorldBatch::set_rule(const Rule &rule) {
+    this->rule = rule;
+    for (unsigned int i = 0; i < this->count; i++) {
+        this->periods[i] = 0;
+        this->history_sizes[i] = 0;
+    }
+}
+
+/**
+ * WorldBatch::get_threads()
+ *
+ * Gets the number of threads the worlds are stepped on.
+ *
+ * @return
+ *      The number of threads, 1 unless changed with WorldBatch::set_threads(threads).
+ */
+unsigned int WorldBatch::get_threads() const {
+    if (this->pool) {
+        return this->pool->get_threads();
+    }
+    return 1;
+}
+
+/**
+ * WorldBatch::set_threads(threads)
+ *
+ * Selects how many threads WorldBatch::advance(steps, toroidal) and WorldBatch::randomize(seed, first, density)
+ * run on. The threads are created here and persist until the thread count changes or the batch is destroyed.
+ *
+ * @param threads
+ *      The number of threads to use. 1 runs on the calling thread only, 0 uses one thread per hardware thread.
+ */
+void WorldBatch::set_threads(const unsigned int threads) {
+    if (threads == 1) {
+        this->pool.reset();
+    }
+    else {
+        this->pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+/**
+ * WorldBatch::get_cycle_detection()
+ *
+ * Gets the longest period of cycle each world is checked for.
+ *
+ * @return
+ *      The longest period detected, or 0 if cycle detection is off, which it is unless changed with
+ *      WorldBatch::set_cycle_detection(max_period).
+ */
+unsigned int WorldBatch::get_cycle_detection() const {
+    return this->max_period;
+}
+
+/**
+ * WorldBatch::set_cycle_detection(max_period)
+ *
+ * Turns on termination of the worlds which repeat within max_period generations, or turns it off with
+ * max_period = 0, as World::set_cycle_detection(max_period) does for a single world. A world which has died out
+ * has a period of 1. Cycles found so far are forgotten.
+ *
+ * @example
+ *
+ *      // Run a batch of soups until each has settled into still lifes and oscillators of period up to 60
+ *      batch.set_cycle_detection(60);
+ *      batch.advance(10000);
+ *      std::cout << batch.get_running() << " soups still running" << std::endl;
+ *
+ * @param max_period
+ *      The longest period to detect.
+ */
+void WorldBatch::set_cycle_detection(const unsigned int max_period) {
+    this->max_period = max_period;
+    this->recent_hashes.assign((size_t)this->count * max_period, 0);
+    for (unsigned int i = 0; i < this->count; i++) {
+        this->periods[i] = 0;
+        this->history_sizes[i] = 0;
+    }
+}
+
+/**
+ * hash_world(words, count)
+ *
+ * Hash the words of one world, with the rotate and multiply per word of World's tile hash,
+ * finished with the finalizer of splitmix64.
+ */
+static inline uint64_t hash_world(const uint64_t *words, const unsigned int count) {
+    uint64_t hash = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        const uint64_t mixed = hash ^ words[i];
+        hash = ((mixed << 23) | (mixed >> 41)) * 0x9e3779b97f4a7c15ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/**
+ * step_narrow<CONWAY>(curr, next, width, height, toroidal, birth, survival)
+ *
+ * Step a world at most 64 cells wide, whose every row is a single word. The neighbours of a row are plain shifts
+ * of the rows above and below it kept in registers, with no carries between words, which is several times faster
+ * than the general kernel of BitGrid::step_words for the small worlds batches are made of.
+ */
+template <bool CONWAY>
+static void step_narrow(const uint64_t *curr, uint64_t *next, const unsigned int width, const unsigned int height,
+    const bool torodial, const uint16_t birth, const uint16_t survival) {
+    const uint64_t mask = width == 64 ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+    const unsigned int wrap = torodial ? width - 1 : 64;
+    // west has the cell at x - 1 in bit x, east has the cell at x + 1 in bit x, wrapping around a torus
+    auto west = [&](const uint64_t row) {
+        return (row << 1) | (wrap < 64 ? row >> wrap : 0);
+    };
+    auto east = [&](const uint64_t row) {
+        return (row >> 1) | (wrap < 64 ? (row & 1) << wrap : 0);
+    };
+
+    uint64_t above = torodial ? curr[height - 1] : 0;
+    uint64_t row = curr[0];
+    for (unsigned int y = 0; y < height; y++) {
+        const uint64_t below = y + 1 < height ? curr[y + 1] : (torodial ? curr[0] : 0);
+        const BitLogic::Counts counts = BitLogic::count_neighbours(west(above), above, east(above),
+            west(row), east(row), west(below), below, east(below));
+        next[y] = (CONWAY ? BitLogic::conway(counts, row) : BitLogic::apply(counts, row, birth, survival)) & mask;
+        above = row;
+        row = below;
+    }
+}
+
+/**
+ * WorldBatch::advance(steps, toroidal)
+ *
+ * Advance every world which has not terminated by a number of steps, or until it terminates.
+ * The worlds are split into chunks of 64 which the threads take in turn, see WorldBatch::set_threads(threads).
+ *
+ * @example
+ *
+ *      // Run a batch of 100000 random 32x32 soups for 1000 generations on every core
+ *      WorldBatch batch(100000, 32);
+ *      batch.set_threads(0);
+ *      batch.randomize(1, 0);
+ *      batch.advance(1000);
+ *
+ * @param steps
+ *      The number of steps to advance each world.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then every world is a torus, where the left edge wraps to the right edge
+ *      and the top to the bottom. Defaults to false.
+ */
+void WorldBatch::advance(const unsigned long long steps, const bool torodial) {
+    if (steps == 0 || this->words_per_world == 0) {
+        return;
+    }
+    this->for_each_world([&](unsigned int i0, unsigned int i1) {
+        // A world is stepped back and forth between its slot of the batch and this buffer
+        static thread_local std::vector<uint64_t> scratch;
+        for (unsigned int i = i0; i < i1; i++) {
+            this->advance_world(i, steps, torodial, scratch);
+        }
+    });
+}
+
+/**
+ * WorldBatch::advance_world(index, steps, toroidal, scratch)
+ *
+ * Private helper which advances one world until it has taken the steps or terminated, leaving the result
+ * in its slot of the batch and updating its population, generation and period.
+ */
+void WorldBatch::advance_world(const unsigned int index, const unsigned long long steps, const bool torodial,
+    std::vector<uint64_t> &scratch) {
+    if (this->periods[index] > 0) {
+        return;
+    }
+    if (scratch.size() < this->words_per_world) {
+        scratch.resize(this->words_per_world);
+    }
+    uint64_t *slot = this->words.data() + (size_t)index * this->words_per_world;
+    uint64_t *curr = slot;
+    uint64_t *next = scratch.data();
+    uint64_t *history = this->recent_hashes.data() + (size_t)index * this->max_period;
+    unsigned long long generation = this->generations[index];
+    unsigned int history_size = this->history_sizes[index];
+    unsigned int period = 0;
+
+    if (this->max_period > 0 && history_size == 0) {
+        history[generation % this->max_period] = hash_world(curr, this->words_per_world);
+        history_size = 1;
+    }
+
+    const bool narrow = this->width <= 64;
+    const bool conway = this->rule == Rule(ConwayRule());
+    const uint16_t birth = this->rule.get_birth();
+    const uint16_t survival = this->rule.get_survival();
+
+    for (unsigned long long step = 0; step < steps; step++) {
+        if (narrow && conway) {
+            step_narrow<true>(curr, next, this->width, this->height, torodial, birth, survival);
+        }
+        else if (narrow) {
+            step_narrow<false>(curr, next, this->width, this->height, torodial, birth, survival);
+        }
+        else {
+            BitGrid::step_words(curr, next, this->width, this->height, 0, this->height, torodial, this->rule);
+        }
+        std::swap(curr, next);
+        generation++;
+
+        if (this->max_period > 0) {
+            // A generation matching the one p generations before it has entered a cycle of period p
+            const uint64_t hash = hash_world(curr, this->words_per_world);
+            for (unsigned int p = 1; p <= history_size; p++) {
+                if (history[(generation - p) % this->max_period] == hash) {
+                    period = p;
+                    break;
+                }
+            }
+            history[generation % this->max_period] = hash;
+            history_size = std::min(history_size + 1, this->max_period);
+            if (period > 0) {
+                break;
+            }
+        }
+    }
+
+    if (curr != slot) {
+        std::memcpy(slot, curr, sizeof(uint64_t) * this->words_per_world);
+    }
+    unsigned int population = 0;
+    for (unsigned int i = 0; i < this->words_per_world; i++) {
+        population += __builtin_popcountll(slot[i]);
+    }
+    this->populations[index] = population;
+    this->generations[index] = generation;
+    this->history_sizes[index] = history_size;
+    this->periods[index] = period;
+}
+
+/**
+ * WorldBatch::get_alive_cells(index)
+ *
+ * Gets the number of alive cells of one world.
+ *
+ * @param index
+ *      The index of the world.
+ *
+ * @return
+ *      The number of alive cells, kept up to date by each call to WorldBatch::advance(steps, toroidal).
+ *
+ * @throws
+ *      std::invalid_argument if the index is not in the batch.
+ */
+unsigned int WorldBatch::get_alive_cells(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("get_alive_cells() : Invalid index.");
+    }
+    return this->populations[index];
+}
+
+/**
+ * WorldBatch::get_generation(index)
+ *
+ * Gets the number of generations one world has been stepped since its state was last set.
+ * A terminated world is not stepped any further, so this is the generation it terminated at.
+ *
+ * @param index
+ *      The index of the world.
+ *
+ * @return
+ *      The generation of the world.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not in the batch.
+ */
+unsigned long long WorldBatch::get_generation(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("get_generation() : Invalid index.");
+    }
+    return this->generations[index];
+}
+
+/**
+ * WorldBatch::is_terminated(index)
+ *
+ * Checks if one world has died out or started to repeat, see WorldBatch::set_cycle_detection(max_period).
+ *
+ * @param index
+ *      The index of the world.
+ *
+ * @return
+ *      True if the world is no longer stepped.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not in the batch.
+ */
+bool WorldBatch::is_terminated(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("is_terminated() : Invalid index.");
+    }
+    return this->periods[index] > 0;
+}
+
+/**
+ * WorldBatch::get_period(index)
+ *
+ * Gets the period of the cycle one world terminated in.
+ *
+ * @param index
+ *      The index of the world.
+ *
+ * @return
+ *      1 for a world which died out or froze into still lifes, p for oscillators of period p,
+ *      or 0 if the world is still running.
+ *
+ * @throws
+ *      std::invalid_argument if the index is not in the batch.
+ */
+unsigned int WorldBatch::get_period(const unsigned int index) const {
+    if (!this->is_valid_index(index)) {
+        throw std::invalid_argument("get_period() : Invalid index.");
+    }
+    return this->periods[index];
+}
+
+/**
+ * WorldBatch::get_running()
+ *
+ * Gets the number of worlds which have not terminated.
+ *
+ * @return
+ *      The number of worlds still stepped by WorldBatch::advance(steps, toroidal).
+ */
+unsigned int WorldBatch::get_running() const {
+    return (unsigned int)std::count(this->periods.begin(), this->periods.end(), 0u);
+}
+
+/**
+ * WorldBatch::reset_world(index)
+ *
+ * Private helper which starts one world again from generation 0 with no cycle found, after its state is replaced.
+ */
+void WorldBatch::reset_world(const unsigned int index) {
+    this->generations[index] = 0;
+    this->periods[index] = 0;
+    this->history_sizes[index] = 0;
+}
+
+/**
+ * WorldBatch::for_each_world(worlds)
+ *
+ * Private helper which splits the worlds into chunks of 64 and invokes worlds(i0, i1) for each chunk [i0, i1)
+ * on the thread pool, returning once every chunk is done. Without a thread pool the whole batch is a single
+ * chunk run on the calling thread.
+ */
+void WorldBatch::for_each_world(const std::function<void(unsigned int, unsigned int)> &worlds) {
+    if (!this->pool || this->count <= CHUNK_SIZE) {
+        worlds(0, this->count);
+        return;
+    }
+    const unsigned int chunks = (this->count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    this->pool->run(chunks, [&](unsigned int chunk) {
+        worlds(chunk * CHUNK_SIZE, std::min(this->count, (chunk + 1) * CHUNK_SIZE));
+    });
+}
+
+bool WorldBatch::is_valid_index(const unsigned int index) const {
+    return index < this->count;
+}
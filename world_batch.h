@@ -0,0 +1,72 @@
+/**
+ * Declares a class representing a batch of small, equally sized, independent worlds.
+ * Rich documentation for the api and behaviour the WorldBatch class can be found in world_batch.cpp.
+ */
+#pragma once
+#include "grid.h"
+#include "rule.h"
+#include "threadpool.h"
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Declare the structure of the WorldBatch class for simulating many small worlds at once.
+ *
+ * Every world is bit-packed like a BitGrid, and the worlds are stored back to back in one buffer. The population,
+ * generation and cycle of each world are kept in parallel arrays, so a whole batch is allocated once however many
+ * worlds it holds, and advanced with one call spread across a ThreadPool.
+ *
+ * A world which dies out or starts to repeat is terminated and is not stepped any further.
+ */
+class WorldBatch {
+    private:
+        unsigned int count;
+        unsigned int width;
+        unsigned int height;
+        unsigned int words_per_world;
+        std::vector<uint64_t> words;
+        std::vector<unsigned int> populations;
+        std::vector<unsigned long long> generations;
+        std::vector<unsigned int> periods;
+        Rule rule;
+        std::shared_ptr<ThreadPool> pool;
+
+        // The hashes of the last max_period generations of each world, see WorldBatch::set_cycle_detection(max_period)
+        unsigned int max_period;
+        std::vector<uint64_t> recent_hashes;
+        std::vector<unsigned int> history_sizes;
+
+        bool is_valid_index(const unsigned int index) const;
+        void reset_world(const unsigned int index);
+        void advance_world(const unsigned int index, const unsigned long long steps, const bool torodial,
+            std::vector<uint64_t> &scratch);
+        void for_each_world(const std::function<void(unsigned int, unsigned int)> &worlds);
+
+    public:
+        WorldBatch();
+        WorldBatch(const unsigned int count, const unsigned int square_size);
+        WorldBatch(const unsigned int count, const unsigned int width, const unsigned int height);
+
+        unsigned int get_count() const;
+        unsigned int get_width() const;
+        unsigned int get_height() const;
+        Grid get_state(const unsigned int index) const;
+        void set_state(const unsigned int index, const Grid &grid);
+        void randomize(const uint64_t seed, const unsigned long long first, const double density = 0.5);
+        void randomize(const uint64_t seed, const unsigned long long first, const double density,
+            const unsigned int x0, const unsigned int y0, const unsigned int x1, const unsigned int y1);
+        Rule get_rule() const;
+        void set_rule(const Rule &rule);
+        unsigned int get_threads() const;
+        void set_threads(const unsigned int threads);
+        unsigned int get_cycle_detection() const;
+        void set_cycle_detection(const unsigned int max_period);
+        void advance(const unsigned long long steps, const bool torodial = false);
+        unsigned int get_alive_cells(const unsigned int index) const;
+        unsigned long long get_generation(const unsigned int index) const;
+        bool is_terminated(const unsigned int index) const;
+        unsigned int get_period(const unsigned int index) const;
+        unsigned int get_running() const;
+
+};
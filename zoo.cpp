@@ -18,14 +18,47 @@
  *                padded with zero or more 0 bits.
  *              - a 0 bit should be considered Cell::DEAD, a 1 bit should be considered Cell::ALIVE.
  *
+ *      - Grids can be loaded from and saved to the run length encoded (RLE) format used by most Life software.
+ *          - RLE files are composed of:
+ *              - zero or more comment lines starting with a (hash) '#'.
+ *              - a header line of the form "x = width, y = height, rule = B3/S23", the rule is optional.
+ *              - runs of cells, each an optional count followed by 'b' for Cell::DEAD or 'o' for Cell::ALIVE,
+ *                with '$' ending a row, also with an optional count, and '!' ending the pattern.
+ *              - whitespace between runs is ignored, and cells missing from the end of a row are Cell::DEAD.
+ *
+ *      - Grids can be loaded from and saved to a tiled checkpoint format, which can be read a region at a time.
+ *          - Tiled files are composed of, in the byte order of the machine which wrote them:
+ *              - the 4 characters "TGOL", a 4 byte int version (currently 1),
+ *                and a 4 byte int 0x01020304 to tell the byte order.
+ *              - 4 byte ints for the grid width, the grid height and the tile size (currently 64).
+ *              - an 8 byte int for the number of stored tiles, and an 8 byte int for the offset of the tile index.
+ *              - the stored tiles, each (tile size) 8 byte ints, one per row, bit x of a row being column x of the tile.
+ *                Tiles without any alive cells are not stored, cells past the edge of the grid are 0 bits.
+ *              - the tile index, one entry per stored tile of a 4 byte int tile column, a 4 byte int tile row
+ *                and an 8 byte int offset of the tile in the file, sorted by tile row and then tile column.
+ *
  * @author 966022
  * @date March, 2020
  */
 #include "zoo.h"
+#include "mapped_file.h"
+#include "threadpool.h"
+#include "bitgrid.h"
 #include <fstream>
 #include <string>
 #include <iostream>
-#include <math.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <cctype>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /**
  * Zoo::glider()
@@ -125,19 +158,87 @@ Grid Zoo::light_weight_spaceship() {
 
 
 /**
- * Zoo::load_ascii(path)
+ * copy_cells(in, out, count)
+ *
+ * Helper for Zoo::load_ascii(path, threads) which validates and copies a run of cell characters.
+ * The ascii characters are the values of Cell::ALIVE and Cell::DEAD, so a valid run is copied as is.
+ * Each block of characters is classified with two byte compares and a single mask test,
+ * AVX2 handles 32 characters per instruction, SSE2 handles 16, and the rest fall back to scalar code.
+ *
+ * @param in
+ *      The characters to read.
+ *
+ * @param out
+ *      The cells to write, count cells are always written but only the valid prefix is meaningful.
+ *
+ * @param count
+ *      The number of characters to read.
+ *
+ * @return
+ *      The index of the first character which is not a cell, or count if they all are.
+ */
+static size_t copy_cells(const unsigned char *in, Cell *out, const size_t count) {
+    size_t x = 0;
+#if defined(__AVX2__)
+    const __m256i alive_avx = _mm256_set1_epi8((char)Cell::ALIVE);
+    const __m256i dead_avx = _mm256_set1_epi8((char)Cell::DEAD);
+    for (; x + 32 <= count; x += 32) {
+        const __m256i block = _mm256_loadu_si256((const __m256i*)(in + x));
+        const __m256i valid = _mm256_or_si256(_mm256_cmpeq_epi8(block, alive_avx), _mm256_cmpeq_epi8(block, dead_avx));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(valid);
+        if (mask != 0xFFFFFFFFu) {
+            return x + __builtin_ctz(~mask);
+        }
+        _mm256_storeu_si256((__m256i*)(out + x), block);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i alive_sse = _mm_set1_epi8((char)Cell::ALIVE);
+    const __m128i dead_sse = _mm_set1_epi8((char)Cell::DEAD);
+    for (; x + 16 <= count; x += 16) {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(in + x));
+        const __m128i valid = _mm_or_si128(_mm_cmpeq_epi8(block, alive_sse), _mm_cmpeq_epi8(block, dead_sse));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(valid);
+        if (mask != 0xFFFFu) {
+            return x + __builtin_ctz(~mask);
+        }
+        _mm_storeu_si128((__m128i*)(out + x), block);
+    }
+#endif
+    for (; x < count; x++) {
+        if (in[x] != (unsigned char)Cell::ALIVE && in[x] != (unsigned char)Cell::DEAD) {
+            return x;
+        }
+        out[x] = (Cell)in[x];
+    }
+    return count;
+}
+
+/**
+ * Zoo::load_ascii(path, threads)
  *
  * Load an ascii file and parse it as a grid of cells.
- * Should be implemented using std::ifstream.
+ *
+ * The file is memory mapped, see mapped_file.cpp. Once the header is parsed every row starts at a known offset,
+ * (width + 1) characters apart, so the rows are split into bands parsed in parallel on a thread pool.
+ * Each band stops at its first error, and the error reported is the one which comes first in the file,
+ * exactly as if the file had been read from start to end.
  *
  * @example
  *
  *      // Load an ascii file from a directory
  *      Grid grid = Zoo::load_ascii("path/to/file.gol");
  *
+ *      // Load a large ascii file using every hardware thread
+ *      Grid large = Zoo::load_ascii("path/to/large.gol", 0);
+ *
  * @param path
  *      The std::string path to the file to read in.
  *
+ * @param threads
+ *      The number of threads to parse with. 1 parses on the calling thread only, 0 uses one thread per hardware thread.
+ *      Small files are always parsed on the calling thread.
+ *
  * @return
  *      Returns the parsed grid.
  *
@@ -146,42 +247,39 @@ Grid Zoo::light_weight_spaceship() {
  *          - The file cannot be opened.
  *          - The parsed width or height is not a positive integer.
  *          - Newline characters are not found when expected during parsing.
- *          - The character for a cell is not the ALIVE or DEAD character.
+ *            The newline after the last row may be missing.
+ *          - The character for a cell is not the ALIVE or DEAD character, or the file ends before the last cell.
  */
-Grid Zoo::load_ascii(const std::string path) {
-    std::ifstream ifs(path, std::ifstream::in);
-
-    if (!ifs.is_open()) {
+Grid Zoo::load_ascii(const std::string path, const unsigned int threads) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(path));
+    }
+    catch (const std::runtime_error &e) {
         throw std::runtime_error("load_ascii() : File cannot be opened.");
     }
+    const char *begin = reinterpret_cast<const char*>(file->data());
+    const char *end = begin + file->size();
 
-    //read width, including multiple digit width
-    char inC = ifs.get();
-    std::string intermediateS = "";
-    while (inC != ' ') {
-        intermediateS += inC;
-        inC = ifs.get();
-    }
-    unsigned int width = 0;
+    //the width runs up to the first space, the height from there up to the first newline
+    const char *space = std::find(begin, end, ' ');
+    const char *newline = std::find(space, end, '\n');
+    int parsed_width = 0;
     try {
-       width = std::stoi(intermediateS);
+        parsed_width = std::stoi(std::string(begin, space));
     }
     catch (std::invalid_argument const &e) {
         throw std::runtime_error("load_ascii() : Cannot parse width, invalid input argument.");
-    } 
+    }
     catch (std::out_of_range const& e) {
         throw std::runtime_error("load_ascii() : Cannot parse width, out of range.");
     }
-
-    //read height
-    intermediateS = "";
-    while (inC != '\n') {
-        intermediateS += inC;
-        inC = ifs.get();
+    if (parsed_width < 0) {
+        throw std::runtime_error("load_ascii() : Cannot parse width, out of range.");
     }
-    unsigned int height = 0;
+    int parsed_height = 0;
     try {
-        height = std::stoi(intermediateS);
+        parsed_height = std::stoi(std::string(space, newline));
     }
     catch (std::invalid_argument const& e) {
         throw std::runtime_error("load_ascii() : Cannot parse height, invalid input argument.");
@@ -189,27 +287,60 @@ Grid Zoo::load_ascii(const std::string path) {
     catch (std::out_of_range const& e) {
         throw std::runtime_error("load_ascii() : Cannot parse height, out of range.");
     }
+    if (parsed_height < 0) {
+        throw std::runtime_error("load_ascii() : Cannot parse height, out of range.");
+    }
+    const unsigned int width = (unsigned int)parsed_width;
+    const unsigned int height = (unsigned int)parsed_height;
 
     Grid grid = Grid(width, height);
 
-    for (unsigned int y = 0; y < height; y++) {
-        for (unsigned int x = 0; x < width; x++) {
-            inC = ifs.get();
-            if (inC == '#') {
-                grid(x, y) = Cell::ALIVE;
-            }
-            else if (inC == ' ') {
-                grid(x, y) = Cell::DEAD;
-            }
-            else {
-                throw std::runtime_error("load_ascii() : Character for a cell is incorrect.");
+    const unsigned char *body = reinterpret_cast<const unsigned char*>(std::min(newline + 1, end));
+    const size_t available = (size_t)(reinterpret_cast<const unsigned char*>(end) - body);
+    const size_t line = (size_t)width + 1;
+
+    //the first bad row found so far, rows after it need not be parsed, and whether it is missing its newline
+    std::atomic<unsigned int> first_error(height);
+    bool missing_newline = false;
+    std::mutex error_mutex;
+
+    auto parse_rows = [&](const unsigned int y0, const unsigned int y1) {
+        for (unsigned int y = y0; y < y1 && y < first_error.load(std::memory_order_relaxed); y++) {
+            const size_t offset = (size_t)y * line;
+            const size_t present = offset < available ? std::min((size_t)width, available - offset) : 0;
+            const bool cells_ok = copy_cells(body + offset, grid.row(y), present) == present && present == width;
+            //allows for last new line to not be there
+            const bool newline_ok = y == height - 1 || (offset + width < available && body[offset + width] == '\n');
+            if (!cells_ok || !newline_ok) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (y < first_error.load()) {
+                    first_error.store(y);
+                    missing_newline = cells_ok;
+                }
+                return;
             }
         }
-        inC = ifs.get();
-        //allows for last new line to not be there
-        if (inC != '\n' && y != height-1) {
+    };
+
+    //threads only pay off once there are a few MB to parse
+    const size_t parallel_bytes = 1 << 22;
+    const unsigned int bands = std::min(threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads, height);
+    if (bands <= 1 || available < parallel_bytes) {
+        parse_rows(0, height);
+    }
+    else {
+        ThreadPool pool(bands);
+        pool.run(bands, [&](unsigned int i) {
+            parse_rows((unsigned int)((unsigned long long)height * i / bands),
+                       (unsigned int)((unsigned long long)height * (i + 1) / bands));
+        });
+    }
+
+    if (first_error.load() < height) {
+        if (missing_newline) {
             throw std::runtime_error("load_ascii() : Missing new line character when expected.");
         }
+        throw std::runtime_error("load_ascii() : Character for a cell is incorrect.");
     }
 
     return grid;
@@ -219,7 +350,7 @@ Grid Zoo::load_ascii(const std::string path) {
  * Zoo::save_ascii(path, grid)
  *
  * Save a grid as an ascii .gol file according to the specified file format.
- * Should be implemented using std::ofstream.
+ * The header and the rows are rendered into one buffer and written to a std::ofstream with a single call.
  *
  * @example
  *
@@ -249,13 +380,16 @@ void Zoo::save_ascii(const std::string path, const Grid grid) {
         throw std::runtime_error("save_ascii() : File cannot be opened.");
     }
 
-    ofs << grid.get_width() << ' ' << grid.get_height() << '\n';
+    //render the header and every row into one buffer, written with a single call
+    const std::string header = std::to_string(grid.get_width()) + ' ' + std::to_string(grid.get_height()) + '\n';
+    const size_t line = (size_t)grid.get_width() + 1;
+    std::string buffer(header.size() + line * grid.get_height(), '\n');
+    std::copy(header.begin(), header.end(), buffer.begin());
+    char *out = &buffer[header.size()];
     for (unsigned int y = 0; y < grid.get_height(); y++) {
-        for (unsigned int x = 0; x < grid.get_width(); x++) {
-            ofs << (char)grid(x, y);
-        }
-        ofs << '\n';
+        std::copy(grid.row(y), grid.row(y) + grid.get_width(), out + y * line);
     }
+    ofs.write(buffer.data(), buffer.size());
 
 }
 
@@ -263,7 +397,10 @@ void Zoo::save_ascii(const std::string path, const Grid grid) {
  * Zoo::load_binary(path)
  *
  * Load a binary file and parse it as a grid of cells.
- * Should be implemented using std::ifstream.
+ *
+ * The file is memory mapped rather than streamed, see mapped_file.cpp, and the packed bits are unpacked
+ * a byte at a time into 8 cells with a single 8 byte store from a lookup table. The cells are written straight
+ * into the grid, which stores its rows contiguously in the same order as the file.
  *
  * @example
  *
@@ -279,56 +416,58 @@ void Zoo::save_ascii(const std::string path, const Grid grid) {
  * @throws
  *      Throws std::runtime_error or sub-class if:
  *          - The file cannot be opened.
- *          - The file ends unexpectedly.
+ *          - The file ends unexpectedly, before the header or before the last 4 byte int of cells.
  */
 Grid Zoo::load_binary(const std::string path) {
-    std::ifstream ifs;
-    ifs.open(path, std::ios::binary | std::ios::in);
-    if (!ifs.is_open()) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(path));
+    }
+    catch (const std::runtime_error &e) {
         throw std::runtime_error("load_binary() : File cannot be opened.");
     }
 
     const unsigned int sizeOfInt = 4;
     const unsigned int bitsInt = 8 * sizeOfInt;
+    if (file->size() < 2 * sizeOfInt) {
+        throw std::runtime_error("load_binary() : Unexpected end of file.");
+    }
 
-    int height;
-    ifs.read(reinterpret_cast<char *>(&height), sizeOfInt);
-    int width;
-    ifs.read(reinterpret_cast<char*>(&width), sizeOfInt);
-    
-    unsigned int bytesHolder;
-
-    Grid grid = Grid(width, height);
+    uint32_t width;
+    uint32_t height;
+    std::memcpy(&width, file->data(), sizeOfInt);
+    std::memcpy(&height, file->data() + sizeOfInt, sizeOfInt);
 
-    //calculate how many ints we need to read from the file
-    int loops = (width * height) / bitsInt;
-    if ((height * width) % bitsInt != 0) {
-        loops++;
+    //the cells are padded to a whole number of ints, all of which must be present
+    const uint64_t cells = (uint64_t)width * height;
+    const uint64_t ints = (cells + bitsInt - 1) / bitsInt;
+    if (file->size() - 2 * sizeOfInt < ints * sizeOfInt) {
+        throw std::runtime_error("load_binary() : Unexpected end of file.");
     }
-    
-    //each loop reads one int (4 bytes) from the file
-    for (int i = 0; i < loops; i++) {
 
-        if (ifs.eof()) {
-            throw std::runtime_error("load_binary() : Unexpected end of file.");
-        }
-
-        ifs.read(reinterpret_cast<char*>(&bytesHolder), sizeOfInt);
-        for (unsigned int j = 0; j < sizeOfInt * 8; j++) {
-            //isolating the rightmost bit in the int and then the next to the left
-            unsigned int a = bytesHolder << (bitsInt - 1 - j);
-            a = a >> (bitsInt - 1);
-            if (a == 1) {
-                //calculating the x and y coordinates based on which element we are at
-                int x = ((i * sizeOfInt * 8) + j) % width;
-                int y = ((i * sizeOfInt * 8) + j) / width;
-
-                grid(x, y) = Cell::ALIVE;
+    //unpack[byte] is the 8 cells of a byte, bit 0 first
+    static const std::array<uint64_t, 256> unpack = [] {
+        std::array<uint64_t, 256> table;
+        for (unsigned int byte = 0; byte < 256; byte++) {
+            Cell eight[8];
+            for (unsigned int bit = 0; bit < 8; bit++) {
+                eight[bit] = ((byte >> bit) & 1) ? Cell::ALIVE : Cell::DEAD;
             }
+            std::memcpy(&table[byte], eight, sizeof(eight));
         }
+        return table;
+    }();
 
+    Grid grid = Grid(width, height);
+    const unsigned char *bits = file->data() + 2 * sizeOfInt;
+    Cell *out = grid.data();
+    const uint64_t whole_bytes = cells / 8;
+    for (uint64_t i = 0; i < whole_bytes; i++) {
+        std::memcpy(out + 8 * i, &unpack[bits[i]], 8);
+    }
+    for (uint64_t cell = whole_bytes * 8; cell < cells; cell++) {
+        out[cell] = ((bits[cell / 8] >> (cell % 8)) & 1) ? Cell::ALIVE : Cell::DEAD;
     }
-    ifs.close();
     return grid;
 }
 
@@ -378,40 +517,537 @@ void Zoo::save_binary(const std::string path, const Grid grid) {
         loops++;
     }
 
-    //grid coordinates and out of bound control
-    unsigned int x = 0;
-    unsigned int y = 0;
-    bool outOfBounds = false;
-    if (grid.get_width() == 0) {
-        outOfBounds = true;
-    }
-    unsigned int bufferInt = 0;
+    //rows are contiguous, so the cells are packed in one pass over the whole grid
+    const Cell *cells = grid.data();
+    const size_t total = (size_t)grid.get_width() * grid.get_height();
+    size_t cell = 0;
     //each loop writes an int (4 bytes) to the file
     for (int i = 0; i < loops; i++) {
         //each loop populates a single int with proper values
-        for (int j = 0; j < 32 && !outOfBounds; j++) {
-            if (grid(x,y) == Cell::ALIVE && !outOfBounds) {
-                bufferInt += pow(2, j);
-            }
-            
-            //control the grid pointer
-            if (x == grid.get_width() - 1) {
-                if (y == grid.get_height() - 1) {
-                    outOfBounds = true;
-                }
-                else {
-                    y++;
-                    x = 0;
+        unsigned int bufferInt = 0;
+        for (unsigned int j = 0; j < 32 && cell < total; j++, cell++) {
+            bufferInt |= (unsigned int)(cells[cell] == Cell::ALIVE) << j;
+        }
+        ofs.write((char*)&bufferInt, 4);
+    }
+
+    ofs.close();
+
+}
+
+/**
+ * Zoo::load_rle(path, rule)
+ *
+ * Load a run length encoded (RLE) file and parse it as a grid of cells.
+ *
+ * The file is memory mapped, see mapped_file.cpp, and decoded in a single pass.
+ * Each run is written straight into its row with a bulk fill, dead runs are skipped as the grid starts dead.
+ *
+ * @example
+ *
+ *      // Load an RLE file from a directory, along with its rule
+ *      std::string rule;
+ *      Grid grid = Zoo::load_rle("path/to/file.rle", &rule);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param rule
+ *      If not nullptr, set to the rule named in the header, or an empty string if the header names none.
+ *      A bounded grid suffix such as ":T64,64" is dropped.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The header is missing or its width or height is not a positive integer.
+ *          - A character other than a run, '$', '!' or whitespace is found.
+ *          - An alive cell lies outside the width and height given in the header.
+ */
+Grid Zoo::load_rle(const std::string path, std::string *rule) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(path));
+    }
+    catch (const std::runtime_error &e) {
+        throw std::runtime_error("load_rle() : File cannot be opened.");
+    }
+    const char *in = reinterpret_cast<const char*>(file->data());
+    const char *end = in + file->size();
+
+    //skip the comment lines and any blank lines before the header
+    while (in < end && (*in == '#' || *in == '\n' || *in == '\r')) {
+        in = std::find(in, end, '\n');
+        in = std::min(in + 1, end);
+    }
+    const char *header_end = std::find(in, end, '\n');
+
+    //the header is a list of "key = value" pairs separated by commas
+    long long width = -1;
+    long long height = -1;
+    std::string header_rule;
+    const char *field = in;
+    while (field < header_end) {
+        const char *comma = std::find(field, header_end, ',');
+        const char *equals = std::find(field, comma, '=');
+        if (equals == comma) {
+            throw std::runtime_error("load_rle() : Cannot parse header.");
+        }
+        std::string key(field, equals);
+        key.erase(std::remove_if(key.begin(), key.end(), ::isspace), key.end());
+        //the rule is the last field and may itself contain commas
+        if (key == "rule") {
+            comma = header_end;
+        }
+        std::string value(equals + 1, comma);
+        value.erase(std::remove_if(value.begin(), value.end(), ::isspace), value.end());
+        if (key == "x" || key == "y") {
+            long long parsed = -1;
+            try {
+                size_t used = 0;
+                parsed = std::stoll(value, &used);
+                if (used != value.size()) {
+                    parsed = -1;
                 }
             }
-            else {
-                x++;
+            catch (const std::exception &e) {
+            }
+            if (parsed < 0 || parsed > 0xFFFFFFFFLL) {
+                throw std::runtime_error("load_rle() : Cannot parse header, width and height must be positive integers.");
             }
+            (key == "x" ? width : height) = parsed;
         }
-        ofs.write((char*)&bufferInt, 4);
-        bufferInt = 0;
+        else if (key == "rule") {
+            header_rule = value.substr(0, value.find(':'));
+        }
+        field = comma + 1;
+    }
+    if (width < 0 || height < 0) {
+        throw std::runtime_error("load_rle() : Cannot parse header.");
     }
 
-    ofs.close();
+    Grid grid = Grid((unsigned int)width, (unsigned int)height);
+    unsigned long long x = 0;
+    unsigned long long y = 0;
+    unsigned long long count = 0;
+    for (const char *c = std::min(header_end + 1, end); c < end; c++) {
+        const char token = *c;
+        if (token >= '0' && token <= '9') {
+            count = count * 10 + (unsigned long long)(token - '0');
+            if (count > 0xFFFFFFFFULL) {
+                throw std::runtime_error("load_rle() : Run length out of range.");
+            }
+            continue;
+        }
+        const unsigned long long run = count == 0 ? 1 : count;
+        count = 0;
+        if (token == 'b') {
+            x += run;
+        }
+        else if (token == 'o') {
+            if (y >= (unsigned long long)height || x + run > (unsigned long long)width) {
+                throw std::runtime_error("load_rle() : Pattern exceeds the size given in the header.");
+            }
+            Cell *cells = grid.row((unsigned int)y);
+            std::fill(cells + x, cells + x + run, Cell::ALIVE);
+            x += run;
+        }
+        else if (token == '$') {
+            y += run;
+            x = 0;
+        }
+        else if (token == '!') {
+            break;
+        }
+        else if (!::isspace((unsigned char)token)) {
+            throw std::runtime_error("load_rle() : Character for a run is incorrect.");
+        }
+    }
+
+    if (rule != nullptr) {
+        *rule = header_rule;
+    }
+    return grid;
+}
 
+/**
+ * Zoo::save_rle(path, grid, rule)
+ *
+ * Save a grid as a run length encoded (RLE) file.
+ *
+ * Runs are found with a search for the next cell of the other state, and their tokens are formatted
+ * straight into one output buffer which is written with a single call.
+ * Dead cells at the end of a row are left out, empty rows are folded into the count of the next '$',
+ * and lines are wrapped before 70 characters as the format recommends.
+ *
+ * @example
+ *
+ *      // Save a glider to an RLE file in a directory
+ *      try {
+ *          Zoo::save_rle("path/to/file.rle", Zoo::glider());
+ *      }
+ *      catch (const std::exception &ex) {
+ *          std::cerr << ex.what() << std::endl;
+ *      }
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param grid
+ *      Grid object to be saved.
+ *
+ * @param rule
+ *      The rule written into the header, Conway's B3/S23 by default.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened.
+ */
+void Zoo::save_rle(const std::string path, const Grid grid, const std::string rule) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) {
+        throw std::runtime_error("save_rle() : File cannot be opened.");
+    }
+
+    const unsigned int max_line = 70;
+    std::string buffer = "x = " + std::to_string(grid.get_width()) + ", y = " + std::to_string(grid.get_height()) +
+                         ", rule = " + rule + "\n";
+    buffer.reserve(buffer.size() + grid.get_height() + grid.get_alive_cells() / 4 + 64);
+    size_t line = 0;
+
+    //append a run of a tag, a count of 1 is left implicit and a token never straddles two lines
+    auto append = [&](unsigned long long run, const char tag) {
+        char token[24];
+        char *digits = token + sizeof(token);
+        *--digits = tag;
+        if (run > 1) {
+            while (run > 0) {
+                *--digits = (char)('0' + run % 10);
+                run /= 10;
+            }
+        }
+        const size_t length = (size_t)(token + sizeof(token) - digits);
+        if (line + length > max_line) {
+            buffer += '\n';
+            line = 0;
+        }
+        buffer.append(digits, length);
+        line += length;
+    };
+
+    unsigned long long rows_ended = 0;
+    for (unsigned int y = 0; y < grid.get_height(); y++) {
+        const Cell *cells = grid.row(y);
+        const Cell *row_end = cells + grid.get_width();
+        const Cell *x = std::find(cells, row_end, Cell::ALIVE);
+        if (x == row_end) {
+            rows_ended++;
+            continue;
+        }
+        if (rows_ended > 0) {
+            append(rows_ended, '$');
+        }
+        const Cell *run_start = cells;
+        while (x != row_end) {
+            if (x != run_start) {
+                append((unsigned long long)(x - run_start), 'b');
+            }
+            const Cell *alive_end = std::find(x, row_end, Cell::DEAD);
+            append((unsigned long long)(alive_end - x), 'o');
+            run_start = alive_end;
+            x = std::find(alive_end, row_end, Cell::ALIVE);
+        }
+        rows_ended = 1;
+    }
+    append(1, '!');
+    buffer += '\n';
+
+    ofs.write(buffer.data(), buffer.size());
+}
+
+/**
+ * The fixed size header at the start of a tiled file, see the top of this file for the format.
+ */
+struct TiledHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tile_size;
+    uint64_t tile_count;
+    uint64_t index_offset;
+};
+
+/**
+ * An entry of the tile index at the end of a tiled file.
+ */
+struct TiledEntry {
+    uint32_t tile_x;
+    uint32_t tile_y;
+    uint64_t offset;
+};
+
+static const char TILED_MAGIC[4] = {'T', 'G', 'O', 'L'};
+static const uint32_t TILED_VERSION = 1;
+static const uint32_t TILED_BYTE_ORDER = 0x01020304;
+static const uint32_t TILED_TILE_SIZE = 64;
+
+/**
+ * read_tiled(path, x0, y0, x1, y1, whole)
+ *
+ * Helper for Zoo::load_tiled(path) and Zoo::load_tiled(path, x0, y0, x1, y1) which maps a tiled file,
+ * validates its header and reads the cells in the range [x0, x1) by [y0, y1).
+ *
+ * For each row of tiles in the range, the first stored tile is found with a binary search of the index,
+ * and the stored tiles are then walked until the range ends. Only the header, the searched entries of the index
+ * and the tiles overlapping the range are touched, so the operating system only reads those pages of the file.
+ *
+ * @param whole
+ *      If true the range is ignored and the whole grid is read.
+ *
+ * @return
+ *      The cells in the range.
+ *
+ * @throws
+ *      std::runtime_error if the file cannot be opened or is not a valid tiled file.
+ *      std::invalid_argument if the range is not valid, with the same rules as Grid::crop(x0, y0, x1, y1).
+ */
+static Grid read_tiled(const std::string &path, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1,
+    const bool whole) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(path));
+    }
+    catch (const std::runtime_error &e) {
+        throw std::runtime_error("load_tiled() : File cannot be opened.");
+    }
+
+    TiledHeader header;
+    if (file->size() < sizeof(header)) {
+        throw std::runtime_error("load_tiled() : Unexpected end of file.");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, TILED_MAGIC, sizeof(TILED_MAGIC)) != 0) {
+        throw std::runtime_error("load_tiled() : Not a tiled file.");
+    }
+    if (header.byte_order != TILED_BYTE_ORDER) {
+        throw std::runtime_error("load_tiled() : File was written with a different byte order.");
+    }
+    if (header.version != TILED_VERSION || header.tile_size != TILED_TILE_SIZE) {
+        throw std::runtime_error("load_tiled() : Unsupported version.");
+    }
+    if (header.index_offset % alignof(TiledEntry) != 0 || header.index_offset > file->size() ||
+        header.tile_count > (file->size() - header.index_offset) / sizeof(TiledEntry)) {
+        throw std::runtime_error("load_tiled() : Unexpected end of file.");
+    }
+
+    if (whole) {
+        x0 = 0;
+        y0 = 0;
+        x1 = header.width;
+        y1 = header.height;
+    }
+    else if (x0 >= header.width || x1 > header.width || y0 >= header.height || y1 > header.height) {
+        throw std::invalid_argument("load_tiled() : Invalid coordinates.");
+    }
+    else if (x0 > x1 || y0 > y1) {
+        throw std::invalid_argument("load_tiled() : Negative size of crop window.");
+    }
+
+    Grid grid = Grid(x1 - x0, y1 - y0);
+    if (x0 == x1 || y0 == y1) {
+        return grid;
+    }
+
+    const TiledEntry *first = reinterpret_cast<const TiledEntry*>(file->data() + header.index_offset);
+    const TiledEntry *last = first + header.tile_count;
+    const unsigned int tile_x0 = x0 / TILED_TILE_SIZE;
+    const unsigned int tile_x1 = (x1 - 1) / TILED_TILE_SIZE;
+    const unsigned int tile_y0 = y0 / TILED_TILE_SIZE;
+    const unsigned int tile_y1 = (y1 - 1) / TILED_TILE_SIZE;
+    for (unsigned int tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+        const TiledEntry *entry = std::lower_bound(first, last, tile_y, [tile_x0](const TiledEntry &e, unsigned int ty) {
+            return e.tile_y < ty || (e.tile_y == ty && e.tile_x < tile_x0);
+        });
+        for (; entry != last && entry->tile_y == tile_y && entry->tile_x <= tile_x1; entry++) {
+            if (entry->offset > file->size() || file->size() - entry->offset < TILED_TILE_SIZE * sizeof(uint64_t)) {
+                throw std::runtime_error("load_tiled() : Unexpected end of file.");
+            }
+
+            //the part of the tile inside the range, in grid coordinates
+            const unsigned int left = entry->tile_x * TILED_TILE_SIZE;
+            const unsigned int top = tile_y * TILED_TILE_SIZE;
+            const unsigned int cx0 = std::max(left, x0);
+            const unsigned int cx1 = (unsigned int)std::min((uint64_t)left + TILED_TILE_SIZE, (uint64_t)x1);
+            const unsigned int cy0 = std::max(top, y0);
+            const unsigned int cy1 = (unsigned int)std::min((uint64_t)top + TILED_TILE_SIZE, (uint64_t)y1);
+            const uint64_t mask = (cx1 - left == 64 ? ~(uint64_t)0 : ((uint64_t)1 << (cx1 - left)) - 1) &
+                                  (~(uint64_t)0 << (cx0 - left));
+
+            //the grid starts dead, so only the alive cells need writing
+            const unsigned char *rows = file->data() + entry->offset;
+            for (unsigned int y = cy0; y < cy1; y++) {
+                uint64_t bits;
+                std::memcpy(&bits, rows + (y - top) * sizeof(uint64_t), sizeof(bits));
+                bits &= mask;
+                Cell *cells = grid.row(y - y0) + left - x0;
+                while (bits != 0) {
+                    cells[__builtin_ctzll(bits)] = Cell::ALIVE;
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * Zoo::load_tiled(path)
+ *
+ * Load a whole tiled checkpoint file as a grid of cells.
+ *
+ * @example
+ *
+ *      // Load a checkpoint from a directory
+ *      Grid grid = Zoo::load_tiled("path/to/file.tgol");
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The file is not a tiled file, or was written with a different byte order or an unsupported version.
+ *          - The file ends before the header, the index or a tile.
+ */
+Grid Zoo::load_tiled(const std::string path) {
+    return read_tiled(path, 0, 0, 0, 0, true);
+}
+
+/**
+ * Zoo::load_tiled(path, x0, y0, x1, y1)
+ *
+ * Load the range [x0, x1) by [y0, y1) of a tiled checkpoint file as a grid of cells,
+ * giving the same grid as Zoo::load_tiled(path).crop(x0, y0, x1, y1).
+ * Only the tiles overlapping the range are read, so a small region of a huge file loads in milliseconds.
+ *
+ * @example
+ *
+ *      // Load the 256x256 cells at the top left of a checkpoint
+ *      Grid region = Zoo::load_tiled("path/to/file.tgol", 0, 0, 256, 256);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param x0
+ *      Left coordinate of the region on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the region on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the region on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the region on y-axis (1 greater than the largest index).
+ *
+ * @return
+ *      Returns the cells in the region.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be read, as for Zoo::load_tiled(path).
+ *      Throws std::invalid_argument if x0,y0 or x1,y1 are not valid coordinates within the grid
+ *      or if the region has a negative size.
+ */
+Grid Zoo::load_tiled(const std::string path, const unsigned int x0, const unsigned int y0, const unsigned int x1,
+    const unsigned int y1) {
+    return read_tiled(path, x0, y0, x1, y1, false);
+}
+
+/**
+ * Zoo::save_tiled(path, grid)
+ *
+ * Save a grid as a tiled checkpoint file, see the top of this file for the format.
+ *
+ * The grid is packed and written one row of tiles at a time, tiles without alive cells are skipped,
+ * and the index is written after the tiles, so the file is written in a single pass.
+ *
+ * @example
+ *
+ *      // Save a grid to a checkpoint file in a directory
+ *      try {
+ *          Zoo::save_tiled("path/to/file.tgol", grid);
+ *      }
+ *      catch (const std::exception &ex) {
+ *          std::cerr << ex.what() << std::endl;
+ *      }
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param grid
+ *      Grid object to be saved.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened or written.
+ */
+void Zoo::save_tiled(const std::string path, const Grid &grid) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) {
+        throw std::runtime_error("save_tiled() : File cannot be opened.");
+    }
+
+    TiledHeader header;
+    std::memcpy(header.magic, TILED_MAGIC, sizeof(TILED_MAGIC));
+    header.version = TILED_VERSION;
+    header.byte_order = TILED_BYTE_ORDER;
+    header.width = grid.get_width();
+    header.height = grid.get_height();
+    header.tile_size = TILED_TILE_SIZE;
+    header.tile_count = 0;
+    header.index_offset = 0;
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const unsigned int tiles_x = (grid.get_width() + TILED_TILE_SIZE - 1) / TILED_TILE_SIZE;
+    const unsigned int tiles_y = (grid.get_height() + TILED_TILE_SIZE - 1) / TILED_TILE_SIZE;
+    std::vector<TiledEntry> index;
+    std::vector<uint64_t> tiles((size_t)tiles_x * TILED_TILE_SIZE);
+    uint64_t offset = sizeof(header);
+    for (unsigned int tile_y = 0; tile_y < tiles_y; tile_y++) {
+        //pack a whole row of tiles, so each row of cells is read once from start to end
+        std::fill(tiles.begin(), tiles.end(), 0);
+        const unsigned int top = tile_y * TILED_TILE_SIZE;
+        const unsigned int rows = std::min(TILED_TILE_SIZE, grid.get_height() - top);
+        for (unsigned int y = 0; y < rows; y++) {
+            const Cell *cells = grid.row(top + y);
+            for (unsigned int tile_x = 0; tile_x < tiles_x; tile_x++) {
+                const unsigned int left = tile_x * TILED_TILE_SIZE;
+                tiles[(size_t)tile_x * TILED_TILE_SIZE + y] =
+                    BitGrid::pack(cells + left, std::min(TILED_TILE_SIZE, grid.get_width() - left));
+            }
+        }
+        for (unsigned int tile_x = 0; tile_x < tiles_x; tile_x++) {
+            const uint64_t *tile = tiles.data() + (size_t)tile_x * TILED_TILE_SIZE;
+            if (std::any_of(tile, tile + TILED_TILE_SIZE, [](uint64_t bits) { return bits != 0; })) {
+                ofs.write(reinterpret_cast<const char*>(tile), TILED_TILE_SIZE * sizeof(uint64_t));
+                index.push_back(TiledEntry{tile_x, tile_y, offset});
+                offset += TILED_TILE_SIZE * sizeof(uint64_t);
+            }
+        }
+    }
+    ofs.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(TiledEntry));
+
+    //the header is rewritten now the tiles and the index have been placed
+    header.tile_count = index.size();
+    header.index_offset = offset;
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!ofs) {
+        throw std::runtime_error("save_tiled() : File cannot be written.");
+    }
 }
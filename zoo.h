@@ -21,9 +21,15 @@ namespace Zoo {
         Grid glider();
         Grid r_pentomino();
         Grid light_weight_spaceship();
-        Grid load_ascii(const std::string path);
+        Grid load_ascii(const std::string path, const unsigned int threads = 1);
         void save_ascii(const std::string path, const Grid grid);
         Grid load_binary(const std::string path);
         void save_binary(const std::string path, const Grid grid);
+        Grid load_rle(const std::string path, std::string *rule = nullptr);
+        void save_rle(const std::string path, const Grid grid, const std::string rule = "B3/S23");
+        Grid load_tiled(const std::string path);
+        Grid load_tiled(const std::string path, const unsigned int x0, const unsigned int y0, const unsigned int x1,
+            const unsigned int y1);
+        void save_tiled(const std::string path, const Grid &grid);
 
 };
\ No newline at end of file